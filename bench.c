@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "grafo.h"
+
+//------------------------------------------------------------------------------
+// compara as ordens de reordena_vertices nas travessias de grafo.c
+//
+// uso: ./bench [arquivo ...]
+//
+// roda sobre os arquivos dados (por exemplo exemplos/*.in) e sobre grafos gerados;
+// para cada grafo e cada ordem, mede o tempo de reordenar e o tempo de R repeticoes
+// de calcula_componentes e calcula_biconexao
+
+#define REPETICOES 20
+
+static const char *nomes_ordens[] = {"nenhuma", "entrada", "bfs", "rcm", "grau"};
+
+static double segundos (clock_t inicio) {
+	return (double)(clock () - inicio) / CLOCKS_PER_SEC;
+}
+
+static void mede (const char *rotulo, FILE *f) {
+	for ( int o = ORDEM_NENHUMA; o <= ORDEM_GRAU; o++ ) {
+		rewind (f);
+		grafo *g = le_grafo (f);
+		if ( !g ) return;
+
+		clock_t t = clock ();
+		reordena_vertices (g, (ordem_vertices)o);
+		double t_ordem = segundos (t);
+
+		t = clock ();
+		for ( int r = 0; r < REPETICOES; r++ ) {
+			free (g->componente);
+			free (g->tam_componente);
+			g->componente = NULL;
+			g->tam_componente = NULL;
+			g->n_componentes = 0;
+			calcula_componentes (g);
+		}
+		double t_comp = segundos (t);
+
+		t = clock ();
+		for ( int r = 0; r < REPETICOES; r++ ) {
+			destruir_biconexao (g->biconexao);
+			g->biconexao = NULL;
+			calcula_biconexao (g);
+		}
+		double t_bicon = segundos (t);
+
+		printf ("%-36s %-8s %8u %9u %10.4f %12.4f %12.4f\n", rotulo, nomes_ordens[o],
+			n_vertices (g), n_arestas (g), t_ordem, t_comp, t_bicon);
+		destroi_grafo (g);
+	}
+}
+
+// grade lado x lado com as arestas listadas em ordem aleatoria
+static FILE *gera_grade (unsigned int lado) {
+	FILE *f = tmpfile ();
+	if ( !f ) return NULL;
+
+	unsigned int n = lado * lado;
+	unsigned int *arestas = malloc (sizeof (unsigned int) * 4 * n);
+	if ( !arestas ) {
+		fclose (f);
+		return NULL;
+	}
+
+	unsigned int m = 0;
+	for ( unsigned int i = 0; i < lado; i++ ) {
+		for ( unsigned int j = 0; j < lado; j++ ) {
+			unsigned int v = i * lado + j;
+			if ( j + 1 < lado ) {
+				arestas[2 * m] = v;
+				arestas[2 * m + 1] = v + 1;
+				m++;
+			}
+			if ( i + 1 < lado ) {
+				arestas[2 * m] = v;
+				arestas[2 * m + 1] = v + lado;
+				m++;
+			}
+		}
+	}
+
+	fprintf (f, "grade-%u\n", lado);
+	for ( unsigned int k = m; k > 0; k-- ) {
+		unsigned int e = (unsigned int)rand () % k;
+		fprintf (f, "v%u -- v%u\n", arestas[2 * e], arestas[2 * e + 1]);
+		arestas[2 * e] = arestas[2 * (k - 1)];
+		arestas[2 * e + 1] = arestas[2 * (k - 1) + 1];
+	}
+
+	free (arestas);
+	return f;
+}
+
+// grafo de Erdos-Renyi G(n, m)
+static FILE *gera_erdos_renyi (unsigned int n, unsigned int m) {
+	FILE *f = tmpfile ();
+	if ( !f ) return NULL;
+
+	fprintf (f, "erdos-renyi-%u-%u\n", n, m);
+	for ( unsigned int k = 0; k < m; k++ ) {
+		fprintf (f, "v%u -- v%u\n", (unsigned int)rand () % n, (unsigned int)rand () % n);
+	}
+	return f;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char **argv) {
+	printf ("%-36s %-8s %8s %9s %10s %12s %12s\n", "grafo", "ordem", "vertices", "arestas",
+		"reordena", "componentes", "biconexao");
+
+	for ( int i = 1; i < argc; i++ ) {
+		FILE *f = fopen (argv[i], "r");
+		if ( !f ) {
+			fprintf (stderr, "Erro ao abrir %s\n", argv[i]);
+			continue;
+		}
+		mede (argv[i], f);
+		fclose (f);
+	}
+
+	srand (1);
+
+	FILE *f = gera_grade (60);
+	if ( f ) {
+		mede ("(gerado) grade 60x60", f);
+		fclose (f);
+	}
+
+	f = gera_erdos_renyi (4000, 16000);
+	if ( f ) {
+		mede ("(gerado) erdos-renyi 4000/16000", f);
+		fclose (f);
+	}
+
+	return 0;
+}
@@ -1,716 +1,5096 @@
 
+#define _POSIX_C_SOURCE 200809L
 #include <stdlib.h>
-// #define _POSIX_C_SOURCE 200809L
 #include <stdbool.h>
+#include <stddef.h>
 #include <string.h>
 #include <limits.h> 
 #include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
 
-#include "grafo.h"
+#ifdef GRAFO_ZLIB
+#include <zlib.h>
+#endif
+#ifdef GRAFO_ZSTD
+#include <zstd.h>
+#endif
 
-char *strdup (const char *s);
+#include "grafo.h"
 
-void dfs (vertice *v) {
-	if ( v->visitado ) return;
-	v->visitado = 1;
+void dfs (vertice *v, bool *visitado) {
+	if ( visitado[v->id] ) return;
+	visitado[v->id] = true;
 
 	vizinho *viz = v->vizinhos;
 	while ( viz ) {
-		dfs (viz->destino);
+		dfs (viz->destino, visitado);
 		viz = viz->prox;
 	}
 }
 
-void calcula_componentes (grafo *g) {
-	// Marca todos os vértices como não visitados
-	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
-		v->visitado = 0;
+// Devolve a raiz do conjunto de x, encurtando o caminho pela metade (path halving)
+static unsigned int uf_raiz (unsigned int *pai, unsigned int x) {
+	while ( pai[x] != x ) {
+		pai[x] = pai[pai[x]];
+		x = pai[x];
 	}
+	return x;
+}
 
-	unsigned int contador = 0;
-	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
-		if ( !v->visitado ) {
-			dfs (v);
-			contador++;
-		}
+// Numero de processadores disponiveis (ao menos 1)
+static unsigned int processadores (void) {
+	long nproc = sysconf (_SC_NPROCESSORS_ONLN);
+	return nproc > 0 ? (unsigned int)nproc : 1;
+}
+
+// Roda f sobre os threads argumentos de args (tam bytes cada), um em cada thread (a que
+// chama fica com o primeiro); se uma thread nao puder ser criada, o argumento dela roda
+// ali mesmo
+static void em_paralelo (void *(*f) (void *), void *args, size_t tam, unsigned int threads) {
+	pthread_t *ids = malloc (sizeof (pthread_t) * threads);
+	unsigned int criadas = 0;
+
+	for ( unsigned int t = 1; t < threads; t++ ) {
+		void *arg = (char *)args + t * tam;
+		if ( !ids || pthread_create (&ids[criadas], NULL, f, arg) != 0 ) f (arg);
+		else criadas++;
 	}
-	g->n_componentes = contador;
+	f (args);
+	for ( unsigned int t = 0; t < criadas; t++ ) {
+		pthread_join (ids[t], NULL);
+	}
+	free (ids);
 }
 
-void adiciona_vizinho (vertice *origem, vertice *destino, int peso) {
-	vizinho *novo = malloc (sizeof (vizinho));
-	novo->destino = destino;
-	novo->peso = peso;
-	novo->prox = origem->vizinhos;
-	origem->vizinhos = novo;
+// Liga os conjuntos de u e v num union-find compartilhado entre threads: a raiz maior
+// e pendurada sob a menor com compare-and-swap, de modo que pai[x] <= x sempre e a raiz
+// e o menor id do conjunto (ligacao do Afforest)
+static void une_atomico (unsigned int *pai, unsigned int u, unsigned int v) {
+	unsigned int p1 = __atomic_load_n (&pai[u], __ATOMIC_RELAXED);
+	unsigned int p2 = __atomic_load_n (&pai[v], __ATOMIC_RELAXED);
+
+	while ( p1 != p2 ) {
+		unsigned int alto = p1 > p2 ? p1 : p2;
+		unsigned int baixo = p1 + p2 - alto;
+		unsigned int p_alto = __atomic_load_n (&pai[alto], __ATOMIC_RELAXED);
+
+		if ( p_alto == baixo ) break;
+		if ( p_alto == alto && __atomic_compare_exchange_n (&pai[alto], &p_alto, baixo, false,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED) ) break;
+
+		// alguem mexeu em alto: sobe e tenta de novo
+		p1 = __atomic_load_n (&pai[__atomic_load_n (&pai[alto], __ATOMIC_RELAXED)], __ATOMIC_RELAXED);
+		p2 = __atomic_load_n (&pai[baixo], __ATOMIC_RELAXED);
+	}
 }
 
-vertice *busca_ou_cria_vertice (grafo *g, const char *nome) {
-	vertice *v = g->vertices;
-	while ( v ) {
-		if ( strcmp (v->nome, nome) == 0 )
-			return v;
-		v = v->prox;
+// Salto de ponteiros sobre os ids [ini, fim): cada um passa a apontar direto para a raiz.
+// Roda depois de todas as ligacoes; cada thread so escreve nos seus ids
+static void comprime_atomico (unsigned int *pai, unsigned int ini, unsigned int fim) {
+	for ( unsigned int x = ini; x < fim; x++ ) {
+		unsigned int p = __atomic_load_n (&pai[x], __ATOMIC_RELAXED);
+		unsigned int pp = __atomic_load_n (&pai[p], __ATOMIC_RELAXED);
+		while ( p != pp ) {
+			p = pp;
+			pp = __atomic_load_n (&pai[p], __ATOMIC_RELAXED);
+		}
+		__atomic_store_n (&pai[x], p, __ATOMIC_RELAXED);
 	}
+}
 
-	// não existe ainda, cria
-	vertice *novo = malloc (sizeof (vertice));
-	novo->nome = strdup (nome);
-	novo->vizinhos = NULL;
-	novo->prox = g->vertices;
-	novo->visitado = 0;
+// Troca, em ordem crescente de id, a raiz de cada conjunto comprimido por um rotulo denso;
+// como a raiz e o menor id, ela e rotulada antes dos demais. Conta em tam o tamanho de
+// cada rotulo e devolve quantos ha
+static unsigned int rotula_raizes (unsigned int *pai, unsigned int *tam, unsigned int n) {
+	unsigned int contador = 0;
+	for ( unsigned int i = 0; i < n; i++ ) {
+		unsigned int r = pai[i];
+		pai[i] = (r == i) ? contador++ : pai[r];
+		if ( tam ) tam[pai[i]]++;
+	}
+	return contador;
+}
 
-	g->vertices = novo;
-	g->n_vertices++;
-	return novo;
+//------------------------------------------------------------------------------
+// matriz de adjacencia em bits, montada para grafos densos
+
+#define MAX_MATRIZ_BITS 16384  // acima disso a matriz passaria de 32 MiB
+#define DENSIDADE_BITS 32      // matriz quando ao menos 1/DENSIDADE_BITS dos pares sao arestas
+
+bool usa_matriz_bits (unsigned int n, size_t arestas) {
+	if ( n < 2 || n > MAX_MATRIZ_BITS ) return false;
+	return arestas * 2 * DENSIDADE_BITS >= (size_t)n * (n - 1);
 }
 
-grafo *le_grafo (FILE *f) {
-	char linha[MAX_LINHA];
-	grafo *g = malloc (sizeof (grafo));
-	g->vertices = NULL;
-	g->nome = NULL;
-	g->n_vertices = 0;
-	g->n_arestas = 0;
-	g->n_componentes = 0;
+static void destroi_matriz_bits (matriz_bits *m) {
+	if ( !m ) return;
 
-	while ( fgets (linha, MAX_LINHA, f) ) {
-		linha[strcspn (linha, "\n")] = 0;
+	free (m->bits);
+	free (m);
+}
 
-		if ( linha[0] == '/' && linha[1] == '/' ) continue;
-		if ( strlen (linha) == 0 ) continue;
+// Monta a matriz de g; NULL em caso de erro de alocacao
+static matriz_bits *cria_matriz_bits (grafo *g) {
+	unsigned int n = g->n_vertices;
+	matriz_bits *m = malloc (sizeof (matriz_bits));
+	if ( !m ) return NULL;
+
+	m->n = n;
+	m->palavras = ((size_t)n + 63) / 64;
+	m->bits = calloc (m->palavras * n + 1, sizeof (uint64_t));
+	if ( !m->bits ) {
+		free (m);
+		return NULL;
+	}
 
-		if ( !g->nome ) {
-			g->nome = strdup (linha);
-			if ( !g->nome ) {
-				fprintf (stderr, "Erro ao duplicar nome do grafo\n");
-				exit (1);
-			}
-			continue;
+	for ( vertice *v = g->vertices; v; v = v->prox ) {
+		uint64_t *linha = &m->bits[v->id * m->palavras];
+		for ( vizinho *viz = v->vizinhos; viz; viz = viz->prox ) {
+			unsigned int w = viz->destino->id;
+			linha[w / 64] |= (uint64_t)1 << (w % 64);
 		}
+	}
+	return m;
+}
 
-		char v1[1024], v2[1024];
-		int peso = 0;
+// Troca a matriz de g por uma nova, se o grafo for denso o bastante; sem memoria
+// o grafo so fica sem ela (as listas continuam valendo)
+static void monta_matriz_bits (grafo *g) {
+	destroi_matriz_bits (g->densa);
+	g->densa = usa_matriz_bits (g->n_vertices, g->n_arestas) ? cria_matriz_bits (g) : NULL;
+}
 
-		if ( sscanf (linha, "%s -- %s %d", v1, v2, &peso) >= 2 ) {
-			vertice *a = busca_ou_cria_vertice (g, v1);
-			vertice *b = busca_ou_cria_vertice (g, v2);
+unsigned int grau_matriz_bits (const matriz_bits *m, unsigned int v) {
+	const uint64_t *linha = &m->bits[v * m->palavras];
+	unsigned int grau = 0;
+	for ( size_t i = 0; i < m->palavras; i++ ) grau += (unsigned int)__builtin_popcountll (linha[i]);
+	return grau;
+}
 
-			adiciona_vizinho (a, b, peso);
-			adiciona_vizinho (b, a, peso);
+// Liga em resto os n primeiros bits (os vertices ainda nao alcancados)
+static void enche_bits (uint64_t *resto, unsigned int n) {
+	size_t palavras = ((size_t)n + 63) / 64;
+	memset (resto, 0xff, palavras * sizeof (uint64_t));
+	if ( n % 64 ) resto[palavras - 1] = ((uint64_t)1 << (n % 64)) - 1;
+}
 
-			g->n_arestas++;
-		} else {
-			// vértice isolado
-			busca_ou_cria_vertice (g, linha);
+// Componentes pela matriz: busca em largura em que os vizinhos novos de u saem de uma
+// vez, palavra a palavra, da linha de u com os bits dos ainda nao alcancados.
+// Os componentes sao rotulados na ordem do menor id, como no union-find
+static unsigned int componentes_matriz_bits (const matriz_bits *m, unsigned int *rotulo, unsigned int *tam,
+	unsigned int *fila, uint64_t *resto) {
+	enche_bits (resto, m->n);
+	unsigned int contador = 0;
+
+	for ( unsigned int s = 0; s < m->n; s++ ) {
+		if ( !(resto[s / 64] >> (s % 64) & 1) ) continue;
+
+		unsigned int c = contador++;
+		resto[s / 64] &= ~((uint64_t)1 << (s % 64));
+		rotulo[s] = c;
+		tam[c] = 1;
+		fila[0] = s;
+
+		for ( unsigned int ini = 0, fim = 1; ini < fim; ini++ ) {
+			const uint64_t *linha = &m->bits[fila[ini] * m->palavras];
+			for ( size_t i = 0; i < m->palavras; i++ ) {
+				uint64_t novos = linha[i] & resto[i];
+				if ( !novos ) continue;
+				resto[i] &= ~novos;
+				for ( ; novos; novos &= novos - 1 ) {
+					unsigned int w = (unsigned int)(i * 64) + (unsigned int)__builtin_ctzll (novos);
+					rotulo[w] = c;
+					tam[c]++;
+					fila[fim++] = w;
+				}
+			}
 		}
 	}
 
-	return g;
+	return contador;
 }
 
-unsigned int destroi_grafo (grafo *g) {
-	if ( !g ) return 0;	 // erro, grafo nulo
-
-	vertice *v = g->vertices;
-	while ( v ) {
-		// libera lista de vizinhos do vértice
-		vizinho *viz = v->vizinhos;
-		while ( viz ) {
-			vizinho *tmp_viz = viz;
-			viz = viz->prox;
-			free (tmp_viz);
+#define MIN_COMPONENTES_PARALELO 65536  // abaixo disso o union-find serial ganha
+
+// Fatia dos vertices para uma thread de componentes_paralelo
+typedef struct {
+	vertice **v_arr;
+	unsigned int *rotulo;
+	unsigned int ini, fim;
+} pedaco_componentes;
+
+static void *liga_componentes (void *arg) {
+	pedaco_componentes *p = arg;
+	for ( unsigned int v = p->ini; v < p->fim; v++ ) {
+		for ( vizinho *viz = p->v_arr[v]->vizinhos; viz; viz = viz->prox ) {
+			// cada aresta vista so da ponta de menor id
+			if ( v < viz->destino->id ) une_atomico (p->rotulo, v, viz->destino->id);
 		}
+	}
+	return NULL;
+}
 
-		// libera o nome do vértice
-		free (v->nome);
+static void *comprime_componentes (void *arg) {
+	pedaco_componentes *p = arg;
+	comprime_atomico (p->rotulo, p->ini, p->fim);
+	return NULL;
+}
 
-		// avança para o próximo vértice e libera o atual
-		vertice *tmp_v = v;
-		v = v->prox;
-		free (tmp_v);
+// Componentes em paralelo (estilo Shiloach-Vishkin/Afforest): as threads dividem os
+// vertices e penduram raizes com compare-and-swap no proprio vetor de rotulos; depois
+// cada thread comprime os caminhos dos seus ids. false em caso de erro de alocacao
+static bool componentes_paralelo (grafo *g, unsigned int *rotulo, unsigned int threads) {
+	unsigned int n = g->n_vertices;
+	vertice **v_arr = malloc (sizeof (vertice *) * ((size_t)n + 1));
+	pedaco_componentes *p = malloc (sizeof (pedaco_componentes) * threads);
+	if ( !v_arr || !p ) {
+		free (v_arr);
+		free (p);
+		return false;
 	}
 
-	// libera o nome do grafo
-	free (g->nome);
+	montar_vetor_vertices (g, v_arr);
+	for ( unsigned int i = 0; i < n; i++ ) {
+		rotulo[i] = i;
+	}
+	for ( unsigned int t = 0; t < threads; t++ ) {
+		p[t].v_arr = v_arr;
+		p[t].rotulo = rotulo;
+		p[t].ini = (unsigned int)((unsigned long long)n * t / threads);
+		p[t].fim = (unsigned int)((unsigned long long)n * (t + 1) / threads);
+	}
 
-	// finalmente libera o grafo
-	free (g);
+	em_paralelo (liga_componentes, p, sizeof (pedaco_componentes), threads);
+	em_paralelo (comprime_componentes, p, sizeof (pedaco_componentes), threads);
 
-	return 1;  // sucesso
+	free (v_arr);
+	free (p);
+	return true;
 }
 
-// Função auxiliar para achar o índice do vértice no vetor (busca linear)
-int indice_vertice (vertice **v_arr, unsigned int n, vertice *v) {
+// Calcula os componentes; chamada com g->trava obtida
+static void calcula_componentes_travado (grafo *g) {
+	unsigned int n = g->n_vertices;
+
+	if ( g->componente || n == 0 ) return;
+
+	unsigned int *pai = malloc (sizeof (unsigned int) * n);
+	unsigned int *rotulo = malloc (sizeof (unsigned int) * n);
+	unsigned int *tam = calloc (n, sizeof (unsigned int));
+	if ( !pai || !rotulo || !tam ) {
+		free (pai);
+		free (rotulo);
+		free (tam);
+		fprintf (stderr, "Erro de memória em calcula_componentes()\n");
+		return;
+	}
+
+	// Grafo denso: busca pela matriz de bits, com pai fazendo as vezes de fila
+	uint64_t *resto = g->densa ? malloc (sizeof (uint64_t) * ((size_t)n / 64 + 1)) : NULL;
+	if ( resto ) {
+		unsigned int contador = componentes_matriz_bits (g->densa, rotulo, tam, pai, resto);
+		free (resto);
+		free (pai);
+
+		unsigned int *tam_justo = realloc (tam, sizeof (unsigned int) * contador);
+		g->componente = rotulo;
+		g->tam_componente = tam_justo ? tam_justo : tam;
+		g->n_componentes = contador;
+		return;
+	}
+
+	// Grafo grande (ou modo_paralelo pedido): ligacoes e compressao divididas entre as threads
+	unsigned int threads = g->threads ? g->threads : processadores ();
+	bool paralelo = g->threads > 1 || (g->threads == 0 && n >= MIN_COMPONENTES_PARALELO && threads > 1);
+	if ( paralelo && componentes_paralelo (g, rotulo, threads) ) {
+		free (pai);
+		unsigned int contador = rotula_raizes (rotulo, tam, n);
+
+		unsigned int *tam_justo = realloc (tam, sizeof (unsigned int) * contador);
+		g->componente = rotulo;
+		g->tam_componente = tam_justo ? tam_justo : tam;
+		g->n_componentes = contador;
+		return;
+	}
+
 	for ( unsigned int i = 0; i < n; i++ ) {
-		if ( v_arr[i] == v ) return (int)i;
+		pai[i] = i;
 	}
-	return -1;	// não encontrado (erro)
+
+	// Hooking: cada aresta pendura a raiz de maior id sob a de menor id,
+	// de modo que a raiz de cada conjunto é sempre o menor id do componente
+	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
+		for ( vizinho *viz = v->vizinhos; viz != NULL; viz = viz->prox ) {
+			unsigned int a = uf_raiz (pai, v->id);
+			unsigned int b = uf_raiz (pai, viz->destino->id);
+			if ( a < b ) {
+				pai[b] = a;
+			} else if ( b < a ) {
+				pai[a] = b;
+			}
+		}
+	}
+
+	// Rotulos densos: como a raiz é o menor id, ela é rotulada antes dos demais vertices
+	unsigned int contador = 0;
+	for ( unsigned int i = 0; i < n; i++ ) {
+		unsigned int r = uf_raiz (pai, i);
+		rotulo[i] = (r == i) ? contador++ : rotulo[r];
+		tam[rotulo[i]]++;
+	}
+	free (pai);
+
+	unsigned int *tam_justo = realloc (tam, sizeof (unsigned int) * contador);
+	g->componente = rotulo;
+	g->tam_componente = tam_justo ? tam_justo : tam;
+	g->n_componentes = contador;
 }
 
-int dfs_bipartido (vertice *v, vertice **v_arr, int *cores, unsigned int n, int cor_atual) {
-	int idx = indice_vertice (v_arr, n, v);
-	if ( idx == -1 ) return 0;	// erro, não encontrado
+void calcula_componentes (grafo *g) {
+	pthread_mutex_lock (&g->trava);
+	calcula_componentes_travado (g);
+	pthread_mutex_unlock (&g->trava);
+}
 
-	if ( cores[idx] != 0 ) {
-		// Já colorido, verifica se a cor bate
-		return cores[idx] == cor_atual;
+unsigned int componente (grafo *g, vertice *v) {
+	const unsigned int *rotulos = rotulos_componentes (g);
+	return rotulos ? rotulos[v->id] : 0;
+}
+
+const unsigned int *rotulos_componentes (grafo *g) {
+	calcula_componentes (g);
+	return g->componente;
+}
+
+unsigned int tamanho_componente (grafo *g, unsigned int c) {
+	if ( !rotulos_componentes (g) || c >= g->n_componentes ) return 0;
+	return g->tam_componente[c];
+}
+
+//------------------------------------------------------------------------------
+// arena: blocos encadeados, cada um preenchido sequencialmente
+
+#define TAM_BLOCO_ARENA ((size_t)1 << 20)
+#define ALINHAMENTO_ARENA 16
+
+typedef struct bloco_arena {
+	struct bloco_arena *prox;
+	size_t cap;
+	size_t usado;
+	unsigned char dados[];
+} bloco_arena;
+
+// vetor temporario devolvido a arena, esperando a proxima analise
+typedef struct temporario {
+	struct temporario *prox;
+	size_t cap;
+	unsigned char dados[];
+} temporario;
+
+struct arena {
+	bloco_arena *blocos;       // lista de blocos; o atual e o primeiro com espaco
+	bloco_arena *atual;
+	pthread_mutex_t trava;     // protege livres (as analises podem usar varias threads)
+	temporario *livres;        // vetores temporarios devolvidos, reaproveitados entre grafos
+};
+
+arena *cria_arena (void) {
+	arena *a = calloc (1, sizeof (arena));
+	if ( a && pthread_mutex_init (&a->trava, NULL) != 0 ) {
+		free (a);
+		return NULL;
 	}
+	return a;
+}
 
-	cores[idx] = cor_atual;
+void limpa_arena (arena *a) {
+	if ( !a ) return;
 
-	for ( vizinho *viz = v->vizinhos; viz != NULL; viz = viz->prox ) {
-		if ( !dfs_bipartido (viz->destino, v_arr, cores, n, -cor_atual) )
-			return 0;
+	for ( bloco_arena *b = a->blocos; b != NULL; b = b->prox ) {
+		b->usado = 0;
 	}
-	return 1;
+	a->atual = a->blocos;
 }
 
-unsigned int bipartido (grafo *g) {
-	unsigned int n = g->n_vertices;
-	if ( n == 0 ) return 1;	 // grafo vazio é bipartido
+void destroi_arena (arena *a) {
+	if ( !a ) return;
 
-	vertice **v_arr = malloc (n * sizeof (vertice *));
-	if ( !v_arr ) {
-		fprintf (stderr, "Erro de memória em bipartido()\n");
-		return 0;
+	bloco_arena *b = a->blocos;
+	while ( b ) {
+		bloco_arena *tmp = b;
+		b = b->prox;
+		free (tmp);
 	}
+	temporario *t = a->livres;
+	while ( t ) {
+		temporario *tmp = t;
+		t = t->prox;
+		free (tmp);
+	}
+	pthread_mutex_destroy (&a->trava);
+	free (a);
+}
 
-	// Preencher o vetor com os vértices em ordem
-	unsigned int i = 0;
-	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
-		v_arr[i++] = v;
+// Quantos bytes pular em b para que a proxima alocacao fique alinhada
+static size_t desvio_arena (const bloco_arena *b) {
+	uintptr_t p = (uintptr_t)(b->dados + b->usado);
+	return (size_t)((ALINHAMENTO_ARENA - p % ALINHAMENTO_ARENA) % ALINHAMENTO_ARENA);
+}
+
+// Aloca tam bytes alinhados na arena, reaproveitando blocos ja existentes
+static void *aloca_arena (arena *a, size_t tam) {
+	while ( a->atual && a->atual->cap - a->atual->usado < desvio_arena (a->atual) + tam ) {
+		a->atual = a->atual->prox;
 	}
 
-	int *cores = calloc (n, sizeof (int));
-	if ( !cores ) {
-		free (v_arr);
-		fprintf (stderr, "Erro de memória em bipartido()\n");
-		return 0;
+	if ( !a->atual ) {
+		size_t cap = (tam > TAM_BLOCO_ARENA ? tam : TAM_BLOCO_ARENA) + ALINHAMENTO_ARENA;
+		bloco_arena *b = malloc (sizeof (bloco_arena) + cap);
+		if ( !b ) return NULL;
+		b->cap = cap;
+		b->usado = 0;
+		b->prox = a->blocos;
+		a->blocos = b;
+		a->atual = b;
 	}
 
-	for ( i = 0; i < n; i++ ) {
-		if ( cores[i] == 0 ) {
-			if ( !dfs_bipartido (v_arr[i], v_arr, cores, n, 1) ) {
-				free (v_arr);
-				free (cores);
-				return 0;  // não é bipartido
-			}
-		}
+	a->atual->usado += desvio_arena (a->atual);
+	void *p = a->atual->dados + a->atual->usado;
+	a->atual->usado += tam;
+	return p;
+}
+
+// Pega da arena um vetor temporario de ao menos tam bytes: o menor livre que serve ou,
+// se nenhum serve, um novo no lugar do maior livre (assim a arena guarda no maximo
+// tantos vetores quantos ja foram usados ao mesmo tempo)
+static void *pega_temporario (arena *a, size_t tam) {
+	pthread_mutex_lock (&a->trava);
+	temporario **melhor = NULL, **maior = NULL;
+	for ( temporario **t = &a->livres; *t != NULL; t = &(*t)->prox ) {
+		if ( (*t)->cap >= tam && (!melhor || (*t)->cap < (*melhor)->cap) ) melhor = t;
+		if ( !maior || (*t)->cap > (*maior)->cap ) maior = t;
 	}
+	temporario *achado = NULL;
+	if ( melhor || maior ) {
+		achado = melhor ? *melhor : *maior;
+		*(melhor ? melhor : maior) = achado->prox;
+	}
+	pthread_mutex_unlock (&a->trava);
 
-	free (v_arr);
-	free (cores);
-	return 1;  // é bipartido
+	if ( achado && achado->cap >= tam ) return achado->dados;
+
+	free (achado);
+	achado = malloc (sizeof (temporario) + tam);
+	if ( !achado ) return NULL;
+	achado->cap = tam;
+	return achado->dados;
 }
 
-char *nome (grafo *g) {
-	return g->nome;
+// Devolve a arena a um vetor de pega_temporario; sem arena, libera com free (NULL e
+// ignorado)
+static void devolve_temporario (arena *a, void *p) {
+	if ( !p ) return;
+	if ( !a ) {
+		free (p);
+		return;
+	}
+
+	temporario *t = (temporario *)((unsigned char *)p - offsetof (temporario, dados));
+	pthread_mutex_lock (&a->trava);
+	t->prox = a->livres;
+	a->livres = t;
+	pthread_mutex_unlock (&a->trava);
 }
 
-unsigned int n_vertices (grafo *g) {
-	return g->n_vertices;
+// Vetor temporario de uma analise de g: da arena, se houver, reaproveitando a memoria
+// entre os grafos lidos nela, ou com malloc
+static void *aloca_temporario (grafo *g, size_t tam) {
+	return g->arena ? pega_temporario (g->arena, tam) : malloc (tam);
 }
 
-unsigned int n_arestas (grafo *g) {
-	return g->n_arestas;
+// aloca_temporario com n elementos de tam bytes, zerados
+static void *aloca_temporario_zerado (grafo *g, size_t n, size_t tam) {
+	if ( !g->arena ) return calloc (n, tam);
+
+	void *p = pega_temporario (g->arena, n * tam);
+	if ( p ) memset (p, 0, n * tam);
+	return p;
 }
 
-unsigned int n_componentes (grafo *g) {
-	return g->n_componentes;
+// Libera um vetor de aloca_temporario (NULL e ignorado)
+static void libera_temporario (grafo *g, void *p) {
+	devolve_temporario (g->arena, p);
 }
 
+// Aloca um no do grafo na arena de g, se houver, ou com malloc
+static void *aloca_no (grafo *g, size_t tam) {
+	return g->arena ? aloca_arena (g->arena, tam) : malloc (tam);
+}
+
+// Duplica o nome na arena de g, se houver, ou com strdup
+static char *duplica_nome (grafo *g, const char *nome) {
+	if ( !g->arena ) return strdup (nome);
 
-int encontra_min_distancia(int *dist, bool *visitado, int n_comp) {
-    int min = INT_MAX, min_idx = -1;
-
-    for (int i = 0; i < n_comp; i++) {
-        if (!visitado[i] && dist[i] <= min) {
-            min = dist[i];
-            min_idx = i;
-        }
-    }
-    return min_idx;
-}
-
-int dijkstra_distancia_maxima(vertice *inicio, vertice **componente, int n_comp) {
-    if (n_comp <= 1) return 0;
-
-    int *dist = malloc(sizeof(int) * (size_t)n_comp);
-    bool *visitado = malloc(sizeof(bool) * (size_t)n_comp);
-    if (!dist || !visitado) {
-        free(dist);
-        free(visitado);
-        return -1; // Erro de alocação
-    }
-
-
-    int idx_inicio = -1;
-    for (int i = 0; i < n_comp; i++) {
-        dist[i] = INT_MAX;
-        visitado[i] = false;
-        if (componente[i] == inicio) {
-            idx_inicio = i;
-        }
-    }
-
-    if (idx_inicio == -1) {
-        free(dist);
-        free(visitado);
-        return -1;
-    }
-
-    dist[idx_inicio] = 0;
-
-    for (int count = 0; count < n_comp; count++) {
-        // A chamada aqui agora é muito mais rápida
-        int u_idx = encontra_min_distancia(dist, visitado, n_comp);
-        if (u_idx == -1 || dist[u_idx] == INT_MAX) break;
-
-        visitado[u_idx] = true;
-        vertice *u_vert = componente[u_idx];
-
-        for (vizinho *viz = u_vert->vizinhos; viz; viz = viz->prox) {
-            // Encontra o índice do vizinho. Esta busca ainda é o ponto mais lento,
-            // mas o conserto em `encontra_min_distancia` já deve resolver o problema.
-            int v_idx = -1;
-            for (int i = 0; i < n_comp; i++) {
-                if (componente[i] == viz->destino) {
-                    v_idx = i;
-                    break;
-                }
-            }
-
-            if (v_idx != -1 && !visitado[v_idx]) {
-                int peso_aresta = (viz->peso > 0) ? viz->peso : 1;
-                if (dist[u_idx] + peso_aresta < dist[v_idx]) {
-                    dist[v_idx] = dist[u_idx] + peso_aresta;
-                }
-            }
-        }
-    }
-
-    int max_dist = 0;
-    for (int i = 0; i < n_comp; i++) {
-        if (dist[i] != INT_MAX && dist[i] > max_dist) {
-            max_dist = dist[i];
-        }
-    }
-
-    free(dist);
-    free(visitado);
-    return max_dist;
+	size_t len = strlen (nome) + 1;
+	char *copia = aloca_arena (g->arena, len);
+	if ( copia ) memcpy (copia, nome, len);
+	return copia;
 }
 
-// Função principal para calcular os diâmetros dos componentes.
+// Versao de adiciona_vizinho que aloca o vizinho na arena de g, se houver
+static void adiciona_vizinho_grafo (grafo *g, vertice *origem, vertice *destino, int peso, unsigned int aresta) {
+	vizinho *novo = aloca_no (g, sizeof (vizinho));
+	if ( !novo ) {
+		fprintf (stderr, "Erro de memória em le_grafo()\n");
+		exit (1);
+	}
+	novo->destino = destino;
+	novo->peso = peso;
+	novo->aresta = aresta;
+	novo->prox = origem->vizinhos;
+	origem->vizinhos = novo;
+}
+
+void adiciona_vizinho (vertice *origem, vertice *destino, int peso, unsigned int aresta) {
+	vizinho *novo = malloc (sizeof (vizinho));
+	novo->destino = destino;
+	novo->peso = peso;
+	novo->aresta = aresta;
+	novo->prox = origem->vizinhos;
+	origem->vizinhos = novo;
+}
+
+// Hash FNV-1a do nome
+static size_t hash_nome (const char *nome) {
+	uint64_t h = 14695981039346656037ULL;
+	for ( const unsigned char *c = (const unsigned char *)nome; *c; c++ ) {
+		h ^= *c;
+		h *= 1099511628211ULL;
+	}
+	return (size_t)h;
+}
+
+// Devolve a posicao de nome na tabela: a do vertice com esse nome, ou a vaga onde ele entraria
+static size_t posicao_tabela (const grafo *g, const char *nome) {
+	size_t mascara = g->cap_tabela - 1;
+	size_t i = hash_nome (nome) & mascara;
+	while ( g->tabela[i] && strcmp (g->tabela[i]->nome, nome) != 0 ) {
+		i = (i + 1) & mascara;
+	}
+	return i;
+}
+
+// Troca a tabela de g por nova (zerada, com cap posicoes) e insere nela os vertices
+static void preenche_tabela (grafo *g, vertice **nova, size_t cap) {
+	free (g->tabela);
+	g->tabela = nova;
+	g->cap_tabela = cap;
+	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
+		g->tabela[posicao_tabela (g, v->nome)] = v;
+	}
+}
+
+// Refaz a tabela de dispersao com capacidade cap (potencia de 2) a partir da lista de vertices
+static bool reconstroi_tabela (grafo *g, size_t cap) {
+	vertice **nova = calloc (cap, sizeof (vertice *));
+	if ( !nova ) return false;
+
+	preenche_tabela (g, nova, cap);
+	return true;
+}
+
+vertice *busca_vertice (grafo *g, const char *nome) {
+	if ( !g->tabela ) return NULL;
+	return g->tabela[posicao_tabela (g, nome)];
+}
+
+unsigned int busca_aresta (vertice *u, vertice *v) {
+	for ( vizinho *viz = u->vizinhos; viz != NULL; viz = viz->prox ) {
+		if ( viz->destino == v )
+			return viz->aresta;
+	}
+	return SEM_ARESTA;
+}
+
+vertice *busca_ou_cria_vertice (grafo *g, const char *nome) {
+	vertice *v = busca_vertice (g, nome);
+	if ( v ) return v;
+
+	// mantem a tabela no maximo meio cheia
+	if ( 2 * ((size_t)g->n_vertices + 1) > g->cap_tabela ) {
+		if ( !reconstroi_tabela (g, g->cap_tabela ? 2 * g->cap_tabela : 64) ) {
+			fprintf (stderr, "Erro de memória em busca_ou_cria_vertice()\n");
+			exit (1);
+		}
+	}
+
+	// não existe ainda, cria
+	vertice *novo = aloca_no (g, sizeof (vertice));
+	char *copia = novo ? duplica_nome (g, nome) : NULL;
+	if ( !copia ) {
+		fprintf (stderr, "Erro de memória em busca_ou_cria_vertice()\n");
+		exit (1);
+	}
+	novo->nome = copia;
+	novo->vizinhos = NULL;
+	novo->prox = g->vertices;
+	novo->id = g->n_vertices;
+
+	g->vertices = novo;
+	g->n_vertices++;
+	g->tabela[posicao_tabela (g, nome)] = novo;
+	return novo;
+}
+
+//------------------------------------------------------------------------------
+// leitura da entrada em blocos, com descompressao numa thread separada
+
+#define TAM_BLOCO (1 << 20)	 // bytes por bloco lido/descomprimido
+#define N_BLOCOS 4			 // blocos em transito entre a thread leitora e a do parser
+
+typedef enum { FORMATO_TEXTO, FORMATO_GZIP, FORMATO_ZSTD } formato_entrada;
+
+typedef struct leitor {
+	FILE *f;
+	formato_entrada formato;
+	unsigned char magica[4];  // bytes ja lidos para detectar o formato
+	size_t n_magica;
+	bool erro;                // entrada corrompida ou formato sem suporte
+
+	// anel de blocos cheios, produzidos por produz_bloco e consumidos por proxima_linha
+	char *blocos[N_BLOCOS];
+	size_t tam[N_BLOCOS];
+	unsigned int prox_produzir, prox_consumir, cheios;
+	bool fim;
+	pthread_mutex_t trava;
+	pthread_cond_t tem_bloco, tem_vaga;
+	pthread_t thread;
+	bool com_thread;
+
+	// bloco sendo consumido
+	bool segurando;
+	size_t pos;
+
+	// estado dos descompressores e buffer da entrada comprimida
+	unsigned char *entrada;
+	size_t n_entrada, pos_entrada;
+	bool quadro_aberto;       // o descompressor espera mais dados do quadro/membro atual
+#ifdef GRAFO_ZLIB
+	z_stream z;
+	bool z_iniciado;
+#endif
+#ifdef GRAFO_ZSTD
+	ZSTD_DStream *zs;
+#endif
+} leitor;
+
+// Le ate cap bytes crus de f, entregando antes os bytes magicos guardados
+static size_t le_cru (leitor *l, unsigned char *dst, size_t cap) {
+	size_t n = 0;
+	while ( l->n_magica > 0 && n < cap ) {
+		dst[n++] = l->magica[0];
+		memmove (l->magica, l->magica + 1, --l->n_magica);
+	}
+	return n + fread (dst + n, 1, cap - n, l->f);
+}
+
+// Garante que ha entrada comprimida disponivel; devolve false no fim do arquivo
+static bool recarrega_entrada (leitor *l) {
+	if ( l->pos_entrada < l->n_entrada ) return true;
+	l->n_entrada = le_cru (l, l->entrada, TAM_BLOCO);
+	l->pos_entrada = 0;
+	return l->n_entrada > 0;
+}
+
+// Produz o proximo bloco de texto em dst; devolve o numero de bytes (0 no fim ou em erro)
+static size_t produz_bloco (leitor *l, char *dst) {
+	if ( l->erro ) return 0;
+
+	switch ( l->formato ) {
+		case FORMATO_TEXTO:
+			return le_cru (l, (unsigned char *)dst, TAM_BLOCO);
+
+#ifdef GRAFO_ZLIB
+		case FORMATO_GZIP: {
+			size_t n = 0;
+			while ( n < TAM_BLOCO && recarrega_entrada (l) ) {
+				l->z.next_in = l->entrada + l->pos_entrada;
+				l->z.avail_in = (uInt)(l->n_entrada - l->pos_entrada);
+				l->z.next_out = (Bytef *)dst + n;
+				l->z.avail_out = (uInt)(TAM_BLOCO - n);
+
+				int r = inflate (&l->z, Z_NO_FLUSH);
+				l->pos_entrada = l->n_entrada - l->z.avail_in;
+				n = TAM_BLOCO - l->z.avail_out;
+				l->quadro_aberto = true;
+
+				if ( r == Z_STREAM_END ) {
+					// arquivos .gz podem ter varios membros concatenados
+					inflateReset (&l->z);
+					l->quadro_aberto = false;
+				} else if ( r != Z_OK && r != Z_BUF_ERROR ) {
+					fprintf (stderr, "Erro ao descomprimir entrada gzip: %s\n", l->z.msg ? l->z.msg : "dados invalidos");
+					l->erro = true;
+					return 0;
+				}
+			}
+			if ( n < TAM_BLOCO && l->quadro_aberto ) {
+				fprintf (stderr, "Erro ao descomprimir entrada gzip: arquivo truncado\n");
+				l->erro = true;
+			}
+			return n;
+		}
+#endif
+
+#ifdef GRAFO_ZSTD
+		case FORMATO_ZSTD: {
+			ZSTD_outBuffer saida = {dst, TAM_BLOCO, 0};
+			while ( saida.pos < saida.size && recarrega_entrada (l) ) {
+				ZSTD_inBuffer ent = {l->entrada + l->pos_entrada, l->n_entrada - l->pos_entrada, 0};
+				size_t r = ZSTD_decompressStream (l->zs, &saida, &ent);
+				l->pos_entrada += ent.pos;
+				if ( ZSTD_isError (r) ) {
+					fprintf (stderr, "Erro ao descomprimir entrada zstd: %s\n", ZSTD_getErrorName (r));
+					l->erro = true;
+					return 0;
+				}
+				l->quadro_aberto = r != 0;
+			}
+			if ( saida.pos < saida.size && l->quadro_aberto ) {
+				fprintf (stderr, "Erro ao descomprimir entrada zstd: arquivo truncado\n");
+				l->erro = true;
+			}
+			return saida.pos;
+		}
+#endif
+
+		default:
+			fprintf (stderr, "Entrada comprimida com %s, mas o suporte nao foi compilado\n",
+				l->formato == FORMATO_GZIP ? "gzip (GRAFO_ZLIB)" : "zstd (GRAFO_ZSTD)");
+			l->erro = true;
+			return 0;
+	}
+}
+
+// Thread leitora: enche os blocos vagos do anel ate o fim da entrada
+static void *thread_leitora (void *arg) {
+	leitor *l = arg;
+
+	for ( ;; ) {
+		pthread_mutex_lock (&l->trava);
+		while ( l->cheios == N_BLOCOS ) {
+			pthread_cond_wait (&l->tem_vaga, &l->trava);
+		}
+		unsigned int i = l->prox_produzir;
+		pthread_mutex_unlock (&l->trava);
+
+		size_t n = produz_bloco (l, l->blocos[i]);
+
+		pthread_mutex_lock (&l->trava);
+		if ( n == 0 ) {
+			l->fim = true;
+		} else {
+			l->tam[i] = n;
+			l->prox_produzir = (i + 1) % N_BLOCOS;
+			l->cheios++;
+		}
+		pthread_cond_signal (&l->tem_bloco);
+		pthread_mutex_unlock (&l->trava);
+
+		if ( n == 0 ) return NULL;
+	}
+}
+
+// Espera o proximo bloco cheio; devolve false no fim da entrada
+static bool pega_bloco (leitor *l) {
+	if ( !l->com_thread ) {
+		// sem thread, produz no proprio bloco 0
+		l->tam[0] = l->fim ? 0 : produz_bloco (l, l->blocos[0]);
+		l->fim = l->tam[0] == 0;
+		l->prox_consumir = 0;
+		return !l->fim;
+	}
+
+	pthread_mutex_lock (&l->trava);
+	while ( l->cheios == 0 && !l->fim ) {
+		pthread_cond_wait (&l->tem_bloco, &l->trava);
+	}
+	bool tem = l->cheios > 0;
+	pthread_mutex_unlock (&l->trava);
+	return tem;
+}
+
+// Devolve o bloco consumido para a thread leitora
+static void solta_bloco (leitor *l) {
+	if ( !l->com_thread ) return;
+
+	pthread_mutex_lock (&l->trava);
+	l->prox_consumir = (l->prox_consumir + 1) % N_BLOCOS;
+	l->cheios--;
+	pthread_cond_signal (&l->tem_vaga);
+	pthread_mutex_unlock (&l->trava);
+}
+
+// Copia a proxima linha (sem o '\n', truncada em max - 1 caracteres) para linha.
+// Devolve false quando a entrada acabou.
+static bool proxima_linha (leitor *l, char *linha, size_t max) {
+	size_t n = 0;
+	bool leu = false;
+
+	for ( ;; ) {
+		if ( !l->segurando ) {
+			if ( !pega_bloco (l) ) break;
+			l->segurando = true;
+			l->pos = 0;
+		}
+
+		char *bloco = l->blocos[l->prox_consumir];
+		size_t resto = l->tam[l->prox_consumir] - l->pos;
+		char *nl = memchr (bloco + l->pos, '\n', resto);
+		size_t len = nl ? (size_t)(nl - (bloco + l->pos)) : resto;
+
+		size_t copia = len < max - 1 - n ? len : max - 1 - n;
+		memcpy (linha + n, bloco + l->pos, copia);
+		n += copia;
+		l->pos += len;
+		leu = true;
+
+		if ( nl ) l->pos++;
+		if ( l->pos >= l->tam[l->prox_consumir] ) {
+			l->segurando = false;
+			solta_bloco (l);
+		}
+		if ( nl ) break;
+	}
+
+	linha[n] = '\0';
+	return leu;
+}
+
+// Detecta o formato de f e prepara a leitura; devolve false em erro de alocacao
+static bool abre_leitor (leitor *l, FILE *f) {
+	memset (l, 0, sizeof (leitor));
+	l->f = f;
+
+	l->n_magica = fread (l->magica, 1, 4, f);
+	if ( l->n_magica >= 2 && l->magica[0] == 0x1f && l->magica[1] == 0x8b ) {
+		l->formato = FORMATO_GZIP;
+	} else if ( l->n_magica == 4 && l->magica[0] == 0x28 && l->magica[1] == 0xb5 && l->magica[2] == 0x2f && l->magica[3] == 0xfd ) {
+		l->formato = FORMATO_ZSTD;
+	} else {
+		l->formato = FORMATO_TEXTO;
+	}
+
+	for ( unsigned int i = 0; i < N_BLOCOS; i++ ) {
+		l->blocos[i] = malloc (TAM_BLOCO);
+		if ( !l->blocos[i] ) return false;
+	}
+
+	if ( l->formato != FORMATO_TEXTO ) {
+		l->entrada = malloc (TAM_BLOCO);
+		if ( !l->entrada ) return false;
+	}
+
+#ifdef GRAFO_ZLIB
+	if ( l->formato == FORMATO_GZIP ) {
+		if ( inflateInit2 (&l->z, 15 + 16) != Z_OK ) return false;
+		l->z_iniciado = true;
+	}
+#endif
+#ifdef GRAFO_ZSTD
+	if ( l->formato == FORMATO_ZSTD ) {
+		l->zs = ZSTD_createDStream ();
+		if ( !l->zs ) return false;
+		ZSTD_initDStream (l->zs);
+	}
+#endif
+
+	pthread_mutex_init (&l->trava, NULL);
+	pthread_cond_init (&l->tem_bloco, NULL);
+	pthread_cond_init (&l->tem_vaga, NULL);
+	l->com_thread = pthread_create (&l->thread, NULL, thread_leitora, l) == 0;
+	return true;
+}
+
+// Termina a thread leitora (consumindo o que faltar) e libera o leitor
+static void fecha_leitor (leitor *l) {
+	if ( l->com_thread ) {
+		while ( pega_bloco (l) ) {
+			solta_bloco (l);
+		}
+		pthread_join (l->thread, NULL);
+		pthread_mutex_destroy (&l->trava);
+		pthread_cond_destroy (&l->tem_bloco);
+		pthread_cond_destroy (&l->tem_vaga);
+	}
+
+	for ( unsigned int i = 0; i < N_BLOCOS; i++ ) {
+		free (l->blocos[i]);
+	}
+	free (l->entrada);
+#ifdef GRAFO_ZLIB
+	if ( l->z_iniciado ) inflateEnd (&l->z);
+#endif
+#ifdef GRAFO_ZSTD
+	ZSTD_freeDStream (l->zs);
+#endif
+}
+
+grafo *le_grafo (FILE *f) {
+	return le_grafo_opcoes (f, NULL);
+}
+
+// Libera uma adjacencia compacta
+static void destroi_adjacencia_compacta (adjacencia_compacta *a) {
+	if ( !a ) return;
+
+	free (a->inicio);
+	free (a->destino);
+	free (a->peso);
+	free (a);
+}
+
+// Monta a adjacencia compacta; chamada com g->trava obtida
+static adjacencia_compacta *calcula_adjacencia_compacta_travado (grafo *g) {
+	if ( g->compacta ) return g->compacta;
+
+	unsigned int n = g->n_vertices;
+	adjacencia_compacta *a = calloc (1, sizeof (adjacencia_compacta));
+	vertice **v_arr = malloc (sizeof (vertice *) * ((size_t)n + 1));
+	if ( !a || !v_arr ) goto erro;
+
+	a->n = n;
+	a->largura = n <= (unsigned int)UINT16_MAX + 1 ? sizeof (uint16_t) : sizeof (uint32_t);
+	a->inicio = malloc (sizeof (size_t) * ((size_t)n + 1));
+	if ( !a->inicio ) goto erro;
+
+	// Graus e pesos: o vetor de pesos so existe se alguma aresta vale mais que 1
+	montar_vetor_vertices (g, v_arr);
+	a->inicio[0] = 0;
+	for ( unsigned int v = 0; v < n; v++ ) {
+		size_t grau = 0;
+		for ( vizinho *viz = v_arr[v]->vizinhos; viz; viz = viz->prox ) {
+			grau++;
+			if ( viz->peso > 1 ) a->ponderado = true;
+		}
+		a->inicio[v + 1] = a->inicio[v] + grau;
+	}
+
+	size_t meias = a->inicio[n];
+	a->destino = malloc (a->largura * (meias + 1));
+	if ( a->ponderado ) a->peso = malloc (sizeof (int) * (meias + 1));
+	if ( !a->destino || (a->ponderado && !a->peso) ) goto erro;
+
+	for ( unsigned int v = 0; v < n; v++ ) {
+		size_t k = a->inicio[v];
+		for ( vizinho *viz = v_arr[v]->vizinhos; viz; viz = viz->prox, k++ ) {
+			if ( a->largura == sizeof (uint16_t) ) ((uint16_t *)a->destino)[k] = (uint16_t)viz->destino->id;
+			else ((uint32_t *)a->destino)[k] = viz->destino->id;
+			if ( a->peso ) a->peso[k] = (viz->peso > 0) ? viz->peso : 1;
+		}
+	}
+
+	free (v_arr);
+	g->compacta = a;
+	return a;
+
+erro:
+	destroi_adjacencia_compacta (a);
+	free (v_arr);
+	return NULL;
+}
+
+adjacencia_compacta *calcula_adjacencia_compacta (grafo *g) {
+	pthread_mutex_lock (&g->trava);
+	adjacencia_compacta *a = calcula_adjacencia_compacta_travado (g);
+	pthread_mutex_unlock (&g->trava);
+	return a;
+}
+
+// Cria um grafo vazio, sem nome
+static grafo *cria_grafo (const opcoes_leitura *op) {
+	grafo *g = malloc (sizeof (grafo));
+	if ( !g ) return NULL;
+
+	g->vertices = NULL;
+	g->nome = NULL;
+	g->n_vertices = 0;
+	g->n_arestas = 0;
+	g->n_componentes = 0;
+	g->componente = NULL;
+	g->tam_componente = NULL;
+	g->biconexao = NULL;
+	g->multigrafo = op && op->multigrafo;
+	g->threads = 0;
+	g->arena_vertices = NULL;
+	g->n_arena_vertices = 0;
+	g->arena_vizinhos = NULL;
+	g->n_arena_vizinhos = 0;
+	pthread_mutex_init (&g->trava, NULL);
+	g->tabela = NULL;
+	g->cap_tabela = 0;
+	g->arena = op ? op->arena : NULL;
+	g->incremental = NULL;
+	g->compacta = NULL;
+	g->densa = NULL;
+	return g;
+}
+
+grafo *le_grafo_opcoes (FILE *f, const opcoes_leitura *op) {
+	char linha[MAX_LINHA];
+	leitor l;
+	grafo *g = NULL;
+	if ( !abre_leitor (&l, f) || !(g = cria_grafo (op)) ) {
+		fecha_leitor (&l);
+		fprintf (stderr, "Erro de memória em le_grafo()\n");
+		return NULL;
+	}
+
+	while ( proxima_linha (&l, linha, MAX_LINHA) ) {
+		if ( linha[0] == '/' && linha[1] == '/' ) continue;
+		if ( strlen (linha) == 0 ) continue;
+
+		if ( !g->nome ) {
+			g->nome = strdup (linha);
+			if ( !g->nome ) {
+				fprintf (stderr, "Erro ao duplicar nome do grafo\n");
+				exit (1);
+			}
+			continue;
+		}
+
+		char v1[1024], v2[1024];
+		int peso = 0;
+
+		if ( sscanf (linha, "%s -- %s %d", v1, v2, &peso) >= 2 ) {
+			vertice *a = busca_ou_cria_vertice (g, v1);
+			vertice *b = busca_ou_cria_vertice (g, v2);
+
+			adiciona_vizinho_grafo (g, a, b, peso, g->n_arestas);
+			adiciona_vizinho_grafo (g, b, a, peso, g->n_arestas);
+
+			g->n_arestas++;
+		} else {
+			// vértice isolado
+			busca_ou_cria_vertice (g, linha);
+		}
+	}
+
+	fecha_leitor (&l);
+	if ( l.erro ) {
+		destroi_grafo (g);
+		return NULL;
+	}
+
+	if ( op && (op->remover_paralelas || op->remover_lacos) ) {
+		compacta_arestas (g, op);
+	}
+
+	if ( op && op->ordem != ORDEM_NENHUMA ) {
+		reordena_vertices (g, op->ordem);
+	}
+
+	if ( !(op && op->sem_matriz_bits) ) monta_matriz_bits (g);
+
+	return g;
+}
+
+// Diz se p aponta para dentro do vetor [inicio, inicio + bytes)
+static bool na_arena (const void *p, const void *inicio, size_t bytes) {
+	uintptr_t x = (uintptr_t)p;
+	uintptr_t a = (uintptr_t)inicio;
+	return inicio && x >= a && x - a < bytes;
+}
+
+// Libera um vizinho, a menos que ele more na arena de vizinhos do grafo ou numa arena externa
+static void libera_vizinho (grafo *g, vizinho *viz) {
+	if ( g->arena ) return;
+	if ( !na_arena (viz, g->arena_vizinhos, g->n_arena_vizinhos * sizeof (vizinho)) ) free (viz);
+}
+
+// Libera um vertice (sem o nome), a menos que ele more na arena de vertices do grafo ou numa arena externa
+static void libera_vertice (grafo *g, vertice *v) {
+	if ( g->arena ) return;
+	if ( !na_arena (v, g->arena_vertices, g->n_arena_vertices * sizeof (vertice)) ) free (v);
+}
+
+// Aresta com pontas normalizadas (a <= b), usada na ordenacao de compacta_arestas
+typedef struct {
+	unsigned int a, b;
+	unsigned int id;
+	int peso;
+} aresta_ordenada;
+
+static int cmp_aresta_ordenada (const void *x, const void *y) {
+	const aresta_ordenada *p = x;
+	const aresta_ordenada *q = y;
+	if ( p->a != q->a ) return p->a < q->a ? -1 : 1;
+	if ( p->b != q->b ) return p->b < q->b ? -1 : 1;
+	if ( p->id != q->id ) return p->id < q->id ? -1 : 1;
+	return 0;
+}
+
+unsigned int compacta_arestas (grafo *g, const opcoes_leitura *op) {
+	unsigned int m = g->n_arestas;
+	if ( m == 0 ) return 0;
+
+	aresta_ordenada *arestas = malloc (sizeof (aresta_ordenada) * m);
+	unsigned int *novo_id = malloc (sizeof (unsigned int) * m);
+	int *novo_peso = malloc (sizeof (int) * m);
+	if ( !arestas || !novo_id || !novo_peso ) {
+		free (arestas);
+		free (novo_id);
+		free (novo_peso);
+		fprintf (stderr, "Erro de memória em compacta_arestas()\n");
+		return 0;
+	}
+
+	// Cada aresta aparece nas duas pontas; basta guardar uma das vistas
+	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
+		for ( vizinho *viz = v->vizinhos; viz != NULL; viz = viz->prox ) {
+			if ( v->id <= viz->destino->id ) {
+				arestas[viz->aresta] = (aresta_ordenada){v->id, viz->destino->id, viz->aresta, viz->peso};
+			}
+		}
+	}
+
+	qsort (arestas, m, sizeof (aresta_ordenada), cmp_aresta_ordenada);
+
+	// Resolve cada grupo de copias do mesmo par; a primeira do grupo é a primeira lida
+	unsigned int mantidas = 0;
+	for ( unsigned int i = 0; i < m; ) {
+		unsigned int j = i + 1;
+		if ( op->remover_paralelas ) {
+			while ( j < m && arestas[j].a == arestas[i].a && arestas[j].b == arestas[i].b ) j++;
+		}
+
+		if ( op->remover_lacos && arestas[i].a == arestas[i].b ) {
+			for ( unsigned int k = i; k < j; k++ ) {
+				novo_id[arestas[k].id] = SEM_ARESTA;
+			}
+			i = j;
+			continue;
+		}
+
+		int peso = arestas[i].peso;
+		if ( op->peso == PESO_MINIMO ) {
+			for ( unsigned int k = i + 1; k < j; k++ ) {
+				if ( arestas[k].peso < peso ) peso = arestas[k].peso;
+			}
+		} else if ( op->peso == PESO_MULTIPLICIDADE && op->remover_paralelas ) {
+			peso = (int)(j - i);
+		}
+
+		novo_id[arestas[i].id] = mantidas++;
+		novo_peso[arestas[i].id] = peso;
+		for ( unsigned int k = i + 1; k < j; k++ ) {
+			novo_id[arestas[k].id] = SEM_ARESTA;
+		}
+		i = j;
+	}
+
+	// Compacta as listas de vizinhos no lugar, renumerando as arestas que ficam
+	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
+		vizinho **elo = &v->vizinhos;
+		while ( *elo ) {
+			vizinho *viz = *elo;
+			unsigned int id = viz->aresta;
+			if ( novo_id[id] == SEM_ARESTA ) {
+				*elo = viz->prox;
+				libera_vizinho (g, viz);
+			} else {
+				viz->aresta = novo_id[id];
+				viz->peso = novo_peso[id];
+				elo = &viz->prox;
+			}
+		}
+	}
+
+	free (arestas);
+	free (novo_id);
+	free (novo_peso);
+
+	g->n_arestas = mantidas;
+	destruir_biconexao (g->biconexao);
+	g->biconexao = NULL;
+	destroi_adjacencia_compacta (g->compacta);
+	g->compacta = NULL;
+	if ( g->densa ) monta_matriz_bits (g);  // lacos sairam da diagonal
+
+	// ids das arestas mudaram: refaz a estrutura incremental, se ativa
+	if ( g->incremental ) ativa_biconexao_incremental (g);
+
+	return m - mantidas;
+}
+
+// Par (grau, id) usado para ordenar vertices por grau
+typedef struct {
+	unsigned int grau;
+	unsigned int id;
+} grau_id;
+
+static int cmp_grau_id (const void *x, const void *y) {
+	const grau_id *p = x;
+	const grau_id *q = y;
+	if ( p->grau != q->grau ) return p->grau < q->grau ? -1 : 1;
+	if ( p->id != q->id ) return p->id < q->id ? -1 : 1;
+	return 0;
+}
+
+static int cmp_vizinho_destino (const void *x, const void *y) {
+	const vizinho *p = x;
+	const vizinho *q = y;
+	if ( p->destino->id != q->destino->id ) return p->destino->id < q->destino->id ? -1 : 1;
+	if ( p->aresta != q->aresta ) return p->aresta < q->aresta ? -1 : 1;
+	return 0;
+}
+
+// Preenche seq com os ids na ordem de uma BFS por componente. Se cuthill_mckee, cada BFS
+// comeca no vertice de menor grau ainda nao visitado e visita os vizinhos por grau crescente.
+static bool ordem_bfs (vertice **v_arr, unsigned int n, const unsigned int *grau, bool cuthill_mckee, unsigned int *seq) {
+	bool *visitado = calloc (n, sizeof (bool));
+	grau_id *inicios = malloc (sizeof (grau_id) * n);
+	grau_id *vizinhos = NULL;
+	unsigned int max_grau = 0;
+	for ( unsigned int i = 0; i < n; i++ ) {
+		if ( grau[i] > max_grau ) max_grau = grau[i];
+	}
+	vizinhos = malloc (sizeof (grau_id) * ((size_t)max_grau + 1));
+	if ( !visitado || !inicios || !vizinhos ) {
+		free (visitado);
+		free (inicios);
+		free (vizinhos);
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < n; i++ ) {
+		inicios[i] = (grau_id){cuthill_mckee ? grau[i] : 0, i};
+	}
+	if ( cuthill_mckee ) qsort (inicios, n, sizeof (grau_id), cmp_grau_id);
+
+	// seq serve tambem de fila: a BFS so acrescenta no fim
+	unsigned int fim = 0;
+	for ( unsigned int k = 0; k < n; k++ ) {
+		unsigned int r = inicios[k].id;
+		if ( visitado[r] ) continue;
+
+		unsigned int ini = fim;
+		visitado[r] = true;
+		seq[fim++] = r;
+		while ( ini < fim ) {
+			unsigned int u = seq[ini++];
+			unsigned int n_viz = 0;
+			for ( vizinho *viz = v_arr[u]->vizinhos; viz != NULL; viz = viz->prox ) {
+				unsigned int w = viz->destino->id;
+				if ( !visitado[w] ) {
+					visitado[w] = true;
+					vizinhos[n_viz++] = (grau_id){grau[w], w};
+				}
+			}
+			if ( cuthill_mckee ) qsort (vizinhos, n_viz, sizeof (grau_id), cmp_grau_id);
+			for ( unsigned int j = 0; j < n_viz; j++ ) {
+				seq[fim++] = vizinhos[j].id;
+			}
+		}
+	}
+
+	free (visitado);
+	free (inicios);
+	free (vizinhos);
+	return true;
+}
+
+bool reordena_vertices (grafo *g, ordem_vertices ordem) {
+	unsigned int n = g->n_vertices;
+	if ( ordem == ORDEM_NENHUMA || n == 0 ) return true;
+
+	vertice **v_arr = malloc (sizeof (vertice *) * n);
+	unsigned int *grau = calloc (n, sizeof (unsigned int));
+	unsigned int *seq = malloc (sizeof (unsigned int) * n);	// ids antigos na nova ordem
+	unsigned int *novo = malloc (sizeof (unsigned int) * n);	// novo id de cada id antigo
+	if ( !v_arr || !grau || !seq || !novo ) {
+		free (v_arr);
+		free (grau);
+		free (seq);
+		free (novo);
+		fprintf (stderr, "Erro de memória em reordena_vertices()\n");
+		return false;
+	}
+
+	montar_vetor_vertices (g, v_arr);
+	size_t meias = 0;
+	for ( unsigned int i = 0; i < n; i++ ) {
+		for ( vizinho *viz = v_arr[i]->vizinhos; viz != NULL; viz = viz->prox ) {
+			grau[i]++;
+		}
+		meias += grau[i];
+	}
+
+	bool ok = true;
+	switch ( ordem ) {
+		case ORDEM_BFS:
+			ok = ordem_bfs (v_arr, n, grau, false, seq);
+			break;
+
+		case ORDEM_RCM:
+			ok = ordem_bfs (v_arr, n, grau, true, seq);
+			for ( unsigned int i = 0; ok && i < n / 2; i++ ) {
+				unsigned int tmp = seq[i];
+				seq[i] = seq[n - 1 - i];
+				seq[n - 1 - i] = tmp;
+			}
+			break;
+
+		case ORDEM_GRAU: {
+			grau_id *pares = malloc (sizeof (grau_id) * n);
+			ok = pares != NULL;
+			if ( ok ) {
+				// grau decrescente, empates pelo id
+				for ( unsigned int i = 0; i < n; i++ ) {
+					pares[i] = (grau_id){UINT_MAX - grau[i], i};
+				}
+				qsort (pares, n, sizeof (grau_id), cmp_grau_id);
+				for ( unsigned int i = 0; i < n; i++ ) {
+					seq[i] = pares[i].id;
+				}
+			}
+			free (pares);
+			break;
+		}
+
+		default:
+			for ( unsigned int i = 0; i < n; i++ ) {
+				seq[i] = i;
+			}
+			break;
+	}
+
+	vertice *nv = ok ? malloc (sizeof (vertice) * n) : NULL;
+	vizinho *nz = nv ? malloc (sizeof (vizinho) * (meias + 1)) : NULL;
+	// A tabela nova e alocada antes de liberar a estrutura antiga: depois disso nao ha
+	// como voltar atras
+	vertice **tabela = nz ? calloc (g->cap_tabela, sizeof (vertice *)) : NULL;
+	if ( !tabela ) {
+		free (nz);
+		free (nv);
+		free (v_arr);
+		free (grau);
+		free (seq);
+		free (novo);
+		fprintf (stderr, "Erro de memória em reordena_vertices()\n");
+		return false;
+	}
+
+	for ( unsigned int k = 0; k < n; k++ ) {
+		novo[seq[k]] = k;
+	}
+
+	// Copia vertices e vizinhos para os blocos contiguos, na nova ordem
+	size_t pos = 0;
+	for ( unsigned int k = 0; k < n; k++ ) {
+		vertice *antigo = v_arr[seq[k]];
+		nv[k] = *antigo;
+		nv[k].id = k;
+		nv[k].prox = (k + 1 < n) ? &nv[k + 1] : NULL;
+		nv[k].vizinhos = grau[seq[k]] ? &nz[pos] : NULL;
+
+		for ( vizinho *viz = antigo->vizinhos; viz != NULL; viz = viz->prox ) {
+			nz[pos] = *viz;
+			nz[pos].destino = &nv[novo[viz->destino->id]];
+			pos++;
+		}
+	}
+
+	// Ordena cada lista pelo id do destino e refaz os encadeamentos
+	pos = 0;
+	for ( unsigned int k = 0; k < n; k++ ) {
+		size_t d = grau[seq[k]];
+		qsort (&nz[pos], d, sizeof (vizinho), cmp_vizinho_destino);
+		for ( size_t j = 0; j < d; j++ ) {
+			nz[pos + j].prox = (j + 1 < d) ? &nz[pos + j + 1] : NULL;
+		}
+		pos += d;
+	}
+
+	// Libera a estrutura antiga (nomes passam para os novos vertices)
+	for ( unsigned int i = 0; i < n; i++ ) {
+		vizinho *viz = v_arr[i]->vizinhos;
+		while ( viz ) {
+			vizinho *tmp_viz = viz;
+			viz = viz->prox;
+			libera_vizinho (g, tmp_viz);
+		}
+		libera_vertice (g, v_arr[i]);
+	}
+	free (g->arena_vertices);
+	free (g->arena_vizinhos);
+
+	g->vertices = nv;
+	preenche_tabela (g, tabela, g->cap_tabela);
+	g->arena_vertices = nv;
+	g->n_arena_vertices = n;
+	g->arena_vizinhos = nz;
+	g->n_arena_vizinhos = meias;
+
+	// Rotulos por id ficaram invalidos
+	free (g->componente);
+	free (g->tam_componente);
+	g->componente = NULL;
+	g->tam_componente = NULL;
+	destruir_biconexao (g->biconexao);
+	g->biconexao = NULL;
+	destroi_adjacencia_compacta (g->compacta);
+	g->compacta = NULL;
+	if ( g->densa ) monta_matriz_bits (g);
+	if ( g->incremental ) ativa_biconexao_incremental (g);
+
+	free (v_arr);
+	free (grau);
+	free (seq);
+	free (novo);
+	return true;
+}
+
+void modo_multigrafo (grafo *g, bool ativo) {
+	if ( g->multigrafo == ativo ) return;
+
+	g->multigrafo = ativo;
+	destruir_biconexao (g->biconexao);
+	g->biconexao = NULL;
+	if ( g->incremental ) ativa_biconexao_incremental (g);
+}
+
+void modo_paralelo (grafo *g, unsigned int threads) {
+	if ( g->threads == threads ) return;
+
+	g->threads = threads;
+	free (g->componente);
+	free (g->tam_componente);
+	g->componente = NULL;
+	g->tam_componente = NULL;
+	destruir_biconexao (g->biconexao);
+	g->biconexao = NULL;
+}
+
+unsigned int destroi_grafo (grafo *g) {
+	if ( !g ) return 0;	 // erro, grafo nulo
+
+	vertice *v = g->vertices;
+	while ( v ) {
+		// libera lista de vizinhos do vértice
+		vizinho *viz = v->vizinhos;
+		while ( viz ) {
+			vizinho *tmp_viz = viz;
+			viz = viz->prox;
+			libera_vizinho (g, tmp_viz);
+		}
+
+		// libera o nome do vértice
+		if ( !g->arena ) free (v->nome);
+
+		// avança para o próximo vértice e libera o atual
+		vertice *tmp_v = v;
+		v = v->prox;
+		libera_vertice (g, tmp_v);
+	}
+
+	// libera os blocos contiguos de reordena_vertices, se houver
+	free (g->arena_vertices);
+	free (g->arena_vizinhos);
+
+	// libera os rotulos de componentes
+	free (g->componente);
+	free (g->tam_componente);
+
+	// libera o indice de biconectividade e a estrutura incremental
+	destruir_biconexao (g->biconexao);
+	desativa_biconexao_incremental (g);
+	destroi_adjacencia_compacta (g->compacta);
+	destroi_matriz_bits (g->densa);
+
+	pthread_mutex_destroy (&g->trava);
+	free (g->tabela);
+
+	// libera o nome do grafo
+	free (g->nome);
+
+	// finalmente libera o grafo
+	free (g);
+
+	return 1;  // sucesso
+}
+
+// Função auxiliar para achar o índice do vértice no vetor
+// Em vetores montados por montar_vetor_vertices o índice é o próprio id (O(1));
+// para outros vetores cai na busca linear
+int indice_vertice (vertice **v_arr, unsigned int n, vertice *v) {
+	if ( v->id < n && v_arr[v->id] == v ) return (int)v->id;
+
+	for ( unsigned int i = 0; i < n; i++ ) {
+		if ( v_arr[i] == v ) return (int)i;
+	}
+	return -1;	// não encontrado (erro)
+}
+
+int dfs_bipartido (vertice *v, vertice **v_arr, int *cores, unsigned int n, int cor_atual) {
+	int idx = indice_vertice (v_arr, n, v);
+	if ( idx == -1 ) return 0;	// erro, não encontrado
+
+	if ( cores[idx] != 0 ) {
+		// Já colorido, verifica se a cor bate
+		return cores[idx] == cor_atual;
+	}
+
+	cores[idx] = cor_atual;
+
+	for ( vizinho *viz = v->vizinhos; viz != NULL; viz = viz->prox ) {
+		if ( !dfs_bipartido (viz->destino, v_arr, cores, n, -cor_atual) )
+			return 0;
+	}
+	return 1;
+}
+
+// Bipartição pela matriz de bits: lado[c] guarda os vertices ja coloridos com c; u de cor
+// c tem conflito se sua linha cruza lado[c], e os vizinhos ainda sem cor vao para o outro lado
+static unsigned int bipartido_matriz_bits (const matriz_bits *m) {
+	size_t p = m->palavras;
+	uint64_t *resto = malloc (sizeof (uint64_t) * (p + 1));
+	uint64_t *lado = calloc (2 * p + 1, sizeof (uint64_t));
+	unsigned int *fila = malloc (sizeof (unsigned int) * ((size_t)m->n + 1));
+	if ( !resto || !lado || !fila ) {
+		free (resto);
+		free (lado);
+		free (fila);
+		fprintf (stderr, "Erro de memória em bipartido()\n");
+		return 0;
+	}
+
+	enche_bits (resto, m->n);
+	unsigned int resposta = 1;
+
+	for ( unsigned int s = 0; s < m->n && resposta; s++ ) {
+		if ( !(resto[s / 64] >> (s % 64) & 1) ) continue;
+
+		resto[s / 64] &= ~((uint64_t)1 << (s % 64));
+		lado[s / 64] |= (uint64_t)1 << (s % 64);
+		fila[0] = s;
+
+		for ( unsigned int ini = 0, fim = 1; ini < fim && resposta; ini++ ) {
+			unsigned int u = fila[ini];
+			const uint64_t *linha = &m->bits[u * p];
+			const uint64_t *mesmo = (lado[u / 64] >> (u % 64) & 1) ? lado : &lado[p];
+			uint64_t *outro = (mesmo == lado) ? &lado[p] : lado;
+
+			for ( size_t i = 0; i < p; i++ ) {
+				if ( linha[i] & mesmo[i] ) {
+					resposta = 0;
+					break;
+				}
+				uint64_t novos = linha[i] & resto[i];
+				resto[i] &= ~novos;
+				outro[i] |= novos;
+				for ( ; novos; novos &= novos - 1 ) {
+					fila[fim++] = (unsigned int)(i * 64) + (unsigned int)__builtin_ctzll (novos);
+				}
+			}
+		}
+	}
+
+	free (resto);
+	free (lado);
+	free (fila);
+	return resposta;
+}
+
+unsigned int bipartido (grafo *g) {
+	unsigned int n = g->n_vertices;
+	if ( n == 0 ) return 1;	 // grafo vazio é bipartido
+	if ( g->densa ) return bipartido_matriz_bits (g->densa);
+
+	vertice **v_arr = malloc (n * sizeof (vertice *));
+	if ( !v_arr ) {
+		fprintf (stderr, "Erro de memória em bipartido()\n");
+		return 0;
+	}
+
+	// Preencher o vetor com os vértices indexados pelo id
+	montar_vetor_vertices (g, v_arr);
+	unsigned int i;
+
+	int *cores = calloc (n, sizeof (int));
+	if ( !cores ) {
+		free (v_arr);
+		fprintf (stderr, "Erro de memória em bipartido()\n");
+		return 0;
+	}
+
+	for ( i = 0; i < n; i++ ) {
+		if ( cores[i] == 0 ) {
+			if ( !dfs_bipartido (v_arr[i], v_arr, cores, n, 1) ) {
+				free (v_arr);
+				free (cores);
+				return 0;  // não é bipartido
+			}
+		}
+	}
+
+	free (v_arr);
+	free (cores);
+	return 1;  // é bipartido
+}
+
+char *nome (grafo *g) {
+	return g->nome;
+}
+
+unsigned int n_vertices (grafo *g) {
+	return g->n_vertices;
+}
+
+unsigned int n_arestas (grafo *g) {
+	return g->n_arestas;
+}
+
+unsigned int n_componentes (grafo *g) {
+	// Com a estrutura incremental a contagem segue atualizada; sem ela, e refeita junto
+	// com os rotulos se uma insercao os descartou
+	if ( !g->incremental ) calcula_componentes (g);
+	return g->n_componentes;
+}
+
+contexto_busca *cria_contexto_busca (grafo *g) {
+	unsigned int n = g->n_vertices;
+
+	contexto_busca *ctx = aloca_temporario (g, sizeof (contexto_busca));
+	if ( !ctx ) return NULL;
+
+	ctx->n = n;
+	ctx->arena = g->arena;
+	ctx->v_arr = aloca_temporario (g, sizeof (vertice *) * ((size_t)n + 1));
+	ctx->dist = aloca_temporario (g, sizeof (int) * ((size_t)n + 1));
+	ctx->marca = aloca_temporario_zerado (g, (size_t)n + 1, sizeof (unsigned int));
+	ctx->heap = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	ctx->pos = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	ctx->geracao = 0;
+
+	ctx->adj = calcula_adjacencia_compacta (g);
+	ctx->densa = g->densa;
+	ctx->resto = g->densa ? aloca_temporario (g, sizeof (uint64_t) * ((size_t)n / 64 + 1)) : NULL;
+
+	if ( !ctx->v_arr || !ctx->dist || !ctx->marca || !ctx->heap || !ctx->pos || !ctx->adj
+		|| (ctx->densa && !ctx->resto) ) {
+		destroi_contexto_busca (ctx);
+		return NULL;
+	}
+
+	montar_vetor_vertices (g, ctx->v_arr);
+	return ctx;
+}
+
+void destroi_contexto_busca (contexto_busca *ctx) {
+	if ( !ctx ) return;
+
+	devolve_temporario (ctx->arena, ctx->v_arr);
+	devolve_temporario (ctx->arena, ctx->dist);
+	devolve_temporario (ctx->arena, ctx->marca);
+	devolve_temporario (ctx->arena, ctx->heap);
+	devolve_temporario (ctx->arena, ctx->pos);
+	devolve_temporario (ctx->arena, ctx->resto);
+	devolve_temporario (ctx->arena, ctx);
+}
+
+// Sobe o elemento da posicao i do heap ate o lugar certo
+static void heap_sobe (contexto_busca *ctx, unsigned int i) {
+	unsigned int x = ctx->heap[i];
+	while ( i > 0 ) {
+		unsigned int p = (i - 1) / 2;
+		if ( ctx->dist[ctx->heap[p]] <= ctx->dist[x] ) break;
+		ctx->heap[i] = ctx->heap[p];
+		ctx->pos[ctx->heap[i]] = i;
+		i = p;
+	}
+	ctx->heap[i] = x;
+	ctx->pos[x] = i;
+}
+
+// Desce o elemento da posicao i de um heap com tam elementos ate o lugar certo
+static void heap_desce (contexto_busca *ctx, unsigned int i, unsigned int tam) {
+	unsigned int x = ctx->heap[i];
+	for ( ;; ) {
+		unsigned int f = 2 * i + 1;
+		if ( f >= tam ) break;
+		if ( f + 1 < tam && ctx->dist[ctx->heap[f + 1]] < ctx->dist[ctx->heap[f]] ) f++;
+		if ( ctx->dist[x] <= ctx->dist[ctx->heap[f]] ) break;
+		ctx->heap[i] = ctx->heap[f];
+		ctx->pos[ctx->heap[i]] = i;
+		i = f;
+	}
+	ctx->heap[i] = x;
+	ctx->pos[x] = i;
+}
+
+// Buscas especializadas pela largura dos indices da adjacencia compacta
+#define TIPO_INDICE uint16_t
+#define SUFIXO 16
+#include "busca_compacta.inc"
+#undef TIPO_INDICE
+#undef SUFIXO
+
+#define TIPO_INDICE uint32_t
+#define SUFIXO 32
+#include "busca_compacta.inc"
+#undef TIPO_INDICE
+#undef SUFIXO
+
+// Busca em largura pela matriz de bits: os vizinhos novos de u saem palavra a palavra
+// da linha de u com os bits dos ainda nao alcancados
+static int bfs_matriz_bits (const matriz_bits *m, unsigned int s, contexto_busca *ctx) {
+	uint64_t *resto = ctx->resto;
+	unsigned int *fila = ctx->heap;
+	unsigned int geracao = ctx->geracao;
+
+	enche_bits (resto, m->n);
+	resto[s / 64] &= ~((uint64_t)1 << (s % 64));
+	ctx->marca[s] = geracao;
+	ctx->dist[s] = 0;
+	fila[0] = s;
+	unsigned int fim = 1;
+
+	for ( unsigned int ini = 0; ini < fim; ini++ ) {
+		unsigned int u = fila[ini];
+		int du = ctx->dist[u] + 1;
+		const uint64_t *linha = &m->bits[u * m->palavras];
+
+		for ( size_t i = 0; i < m->palavras; i++ ) {
+			uint64_t novos = linha[i] & resto[i];
+			if ( !novos ) continue;
+			resto[i] &= ~novos;
+			for ( ; novos; novos &= novos - 1 ) {
+				unsigned int w = (unsigned int)(i * 64) + (unsigned int)__builtin_ctzll (novos);
+				ctx->marca[w] = geracao;
+				ctx->dist[w] = du;
+				fila[fim++] = w;
+			}
+		}
+	}
+
+	// o ultimo a sair da fila e o mais distante
+	return ctx->dist[fila[fim - 1]];
+}
+
+int excentricidade (vertice *origem, contexto_busca *ctx) {
+	// Nova geracao: marcas antigas deixam de valer sem precisar zerar os vetores
+	if ( ++ctx->geracao == 0 ) {
+		memset (ctx->marca, 0, sizeof (unsigned int) * ctx->n);
+		ctx->geracao = 1;
+	}
+
+	const adjacencia_compacta *a = ctx->adj;
+	if ( ctx->densa && !a->ponderado ) return bfs_matriz_bits (ctx->densa, origem->id, ctx);
+	if ( a->largura == sizeof (uint16_t) ) {
+		return a->ponderado ? dijkstra_16 (a, origem->id, ctx) : bfs_16 (a, origem->id, ctx);
+	}
+	return a->ponderado ? dijkstra_32 (a, origem->id, ctx) : bfs_32 (a, origem->id, ctx);
+}
+
+int distancia_busca (const contexto_busca *ctx, vertice *v) {
+	if ( v->id >= ctx->n || ctx->marca[v->id] != ctx->geracao ) return -1;
+	return ctx->dist[v->id];
+}
+
+//------------------------------------------------------------------------------
+// matriz de distancias: Floyd-Warshall em blocos
+
+#define BLOCO_MATRIZ 64                  // lado dos blocos (em elementos)
+#define MAX_MATRIZ 4096                  // maior componente aceito por usa_matriz_distancias
+#define DENSIDADE_MATRIZ 5               // usa a matriz se grau medio >= n / DENSIDADE_MATRIZ
+#define DIST_INFINITA (INT_MAX / 2)      // soma de duas nao transborda
+
+#if defined (__GNUC__)
+// min-plus em 4 inteiros de uma vez (extensao de vetores do gcc/clang)
+typedef int vetor_dist __attribute__ ((vector_size (16)));
+#define LARGURA_VETOR 4
+#endif
+
+// Relaxa o bloco c passando pelos vertices do bloco k: c[i][j] = min(c[i][j], a[i][k] + b[k][j]),
+// onde a esta na linha de blocos de c e b na coluna. Com k no laco externo, vale tambem
+// quando c e o proprio a ou b (o passo k nao muda a linha nem a coluna k)
+static void relaxa_bloco (int *c, const int *a, const int *b, unsigned int passo) {
+	for ( unsigned int k = 0; k < BLOCO_MATRIZ; k++ ) {
+		const int *bk = &b[(size_t)k * passo];
+		for ( unsigned int i = 0; i < BLOCO_MATRIZ; i++ ) {
+			int *ci = &c[(size_t)i * passo];
+			int aik = a[(size_t)i * passo + k];
+			if ( aik >= DIST_INFINITA ) continue;
+#if defined (LARGURA_VETOR)
+			// linhas alinhadas: a matriz e alinhada a 64 bytes e passo e multiplo do bloco
+			vetor_dist va = {aik, aik, aik, aik};
+			vetor_dist *vc = (vetor_dist *)ci;
+			const vetor_dist *vb = (const vetor_dist *)bk;
+			for ( unsigned int j = 0; j < BLOCO_MATRIZ / LARGURA_VETOR; j++ ) {
+				vetor_dist soma = va + vb[j];
+				vetor_dist menor = soma < vc[j];
+				vc[j] = (vc[j] & ~menor) | (soma & menor);
+			}
+#else
+			for ( unsigned int j = 0; j < BLOCO_MATRIZ; j++ ) {
+				int d = aik + bk[j];
+				if ( d < ci[j] ) ci[j] = d;
+			}
+#endif
+		}
+	}
+}
+
+// Floyd-Warshall em blocos (tres fases por bloco diagonal: o proprio bloco, sua linha
+// e coluna de blocos, e o resto da matriz)
+static void floyd_warshall_blocos (int *dist, unsigned int passo) {
+	unsigned int nb = passo / BLOCO_MATRIZ;
+	#define BLOCO(i, j) (&dist[(size_t)(i) * BLOCO_MATRIZ * passo + (size_t)(j) * BLOCO_MATRIZ])
+
+	for ( unsigned int kb = 0; kb < nb; kb++ ) {
+		int *diag = BLOCO (kb, kb);
+		relaxa_bloco (diag, diag, diag, passo);
+
+		for ( unsigned int jb = 0; jb < nb; jb++ ) {
+			if ( jb == kb ) continue;
+			relaxa_bloco (BLOCO (kb, jb), diag, BLOCO (kb, jb), passo);
+			relaxa_bloco (BLOCO (jb, kb), BLOCO (jb, kb), diag, passo);
+		}
+
+		for ( unsigned int ib = 0; ib < nb; ib++ ) {
+			if ( ib == kb ) continue;
+			for ( unsigned int jb = 0; jb < nb; jb++ ) {
+				if ( jb == kb ) continue;
+				relaxa_bloco (BLOCO (ib, jb), BLOCO (ib, kb), BLOCO (kb, jb), passo);
+			}
+		}
+	}
+
+	#undef BLOCO
+}
+
+// Posicao de id em ids[0 .. n) (crescente), ou UINT_MAX
+static unsigned int indice_matriz (const unsigned int *ids, unsigned int n, unsigned int id) {
+	unsigned int ini = 0, fim = n;
+	while ( ini < fim ) {
+		unsigned int meio = ini + (fim - ini) / 2;
+		if ( ids[meio] < id ) ini = meio + 1;
+		else fim = meio;
+	}
+	return (ini < n && ids[ini] == id) ? ini : UINT_MAX;
+}
+
+// Monta e resolve a matriz dos vertices ids[0 .. n) (crescentes, um componente inteiro);
+// fica com ids, que deve ter sido alocado com malloc
+static matriz_distancias *monta_matriz (vertice **v_arr, unsigned int *ids, unsigned int n) {
+	matriz_distancias *m = malloc (sizeof (matriz_distancias));
+	if ( !m ) {
+		free (ids);
+		return NULL;
+	}
+
+	m->n = n;
+	m->passo = (n + BLOCO_MATRIZ - 1) / BLOCO_MATRIZ * BLOCO_MATRIZ;
+	m->ids = ids;
+	m->dist = NULL;
+
+	void *p;
+	if ( posix_memalign (&p, 64, sizeof (int) * (size_t)m->passo * m->passo) != 0 ) {
+		destroi_matriz_distancias (m);
+		return NULL;
+	}
+	m->dist = p;
+
+	size_t total = (size_t)m->passo * m->passo;
+	for ( size_t k = 0; k < total; k++ ) {
+		m->dist[k] = DIST_INFINITA;
+	}
+
+	for ( unsigned int i = 0; i < n; i++ ) {
+		int *linha = &m->dist[(size_t)i * m->passo];
+		linha[i] = 0;
+		for ( vizinho *viz = v_arr[ids[i]]->vizinhos; viz; viz = viz->prox ) {
+			unsigned int j = indice_matriz (ids, n, viz->destino->id);
+			int peso = (viz->peso > 0) ? viz->peso : 1;
+			if ( j != UINT_MAX && j != i && peso < linha[j] ) linha[j] = peso;
+		}
+	}
+
+	floyd_warshall_blocos (m->dist, m->passo);
+	return m;
+}
+
+// Maior distancia da linha i da matriz
+static int maximo_linha (const matriz_distancias *m, unsigned int i) {
+	const int *linha = &m->dist[(size_t)i * m->passo];
+	int max = 0;
+	for ( unsigned int j = 0; j < m->n; j++ ) {
+		if ( linha[j] > max ) max = linha[j];
+	}
+	return max;
+}
+
+matriz_distancias *calcula_matriz_distancias (grafo *g, unsigned int c) {
+	const unsigned int *rotulo = rotulos_componentes (g);
+	if ( !rotulo || c >= g->n_componentes ) return NULL;
+
+	unsigned int n = g->tam_componente[c];
+	unsigned int *ids = malloc (sizeof (unsigned int) * n);
+	vertice **v_arr = malloc (sizeof (vertice *) * g->n_vertices);
+	if ( !ids || !v_arr ) {
+		free (ids);
+		free (v_arr);
+		return NULL;
+	}
+
+	montar_vetor_vertices (g, v_arr);
+	unsigned int k = 0;
+	for ( unsigned int i = 0; i < g->n_vertices; i++ ) {
+		if ( rotulo[i] == c ) ids[k++] = i;
+	}
+
+	matriz_distancias *m = monta_matriz (v_arr, ids, n);
+	free (v_arr);
+	return m;
+}
+
+void destroi_matriz_distancias (matriz_distancias *m) {
+	if ( !m ) return;
+
+	free (m->ids);
+	free (m->dist);
+	free (m);
+}
+
+int distancia_matriz (const matriz_distancias *m, vertice *u, vertice *v) {
+	unsigned int i = indice_matriz (m->ids, m->n, u->id);
+	unsigned int j = indice_matriz (m->ids, m->n, v->id);
+	if ( i == UINT_MAX || j == UINT_MAX ) return -1;
+	return m->dist[(size_t)i * m->passo + j];
+}
+
+int excentricidade_matriz (const matriz_distancias *m, vertice *v) {
+	unsigned int i = indice_matriz (m->ids, m->n, v->id);
+	if ( i == UINT_MAX ) return -1;
+	return maximo_linha (m, i);
+}
+
+bool usa_matriz_distancias (unsigned int n, size_t arestas) {
+	// componentes pequenos saem baratos de qualquer jeito
+	if ( n < BLOCO_MATRIZ || n > MAX_MATRIZ ) return false;
+	return 2 * arestas * DENSIDADE_MATRIZ >= (size_t)n * n;
+}
+
+static int cmp_int (const void *a, const void *b) {
+	int x = *(const int *)a;
+	int y = *(const int *)b;
+	return (x > y) - (x < y);
+}
+
+static double agora (void) {
+	struct timespec t;
+	clock_gettime (CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+// Estado do refinamento dos limites de um componente em limites_diametros
+typedef struct {
+	unsigned int inicio;     // candidatos em membros[inicio .. inicio + n_cand)
+	unsigned int n_cand;     // vertices que ainda podem ter excentricidade > inferior
+	unsigned int buscas;     // buscas ja feitas no componente
+	size_t meias;            // meias-arestas do componente
+	unsigned int fonte;      // vertice de maior grau, fonte da primeira busca
+	unsigned int grau_fonte;
+	long long inferior;
+	long long superior;
+} estado_diametro;
+
+// Faz uma busca no componente e atualiza limites e candidatos
+static void refina_diametro (estado_diametro *e, unsigned int *membros, long long *ecc_inf, long long *ecc_sup, contexto_busca *ctx) {
+	unsigned int *cand = &membros[e->inicio];
+
+	// Escolhe a fonte: a de maior grau (achada ao agrupar os vertices), depois alterna
+	// maior limite superior / menor inferior
+	unsigned int fonte = e->fonte;
+	if ( e->buscas > 0 ) {
+		unsigned int melhor = 0;
+		for ( unsigned int k = 1; k < e->n_cand; k++ ) {
+			unsigned int v = cand[k], b = cand[melhor];
+			if ( e->buscas % 2 == 1 ) {
+				if ( ecc_sup[v] > ecc_sup[b] || (ecc_sup[v] == ecc_sup[b] && ecc_inf[v] < ecc_inf[b]) ) melhor = k;
+			} else {
+				if ( ecc_inf[v] < ecc_inf[b] || (ecc_inf[v] == ecc_inf[b] && ecc_sup[v] > ecc_sup[b]) ) melhor = k;
+			}
+		}
+		fonte = cand[melhor];
+	}
+
+	vertice *s = ctx->v_arr[fonte];
+	long long ecc = excentricidade (s, ctx);
+	e->buscas++;
+
+	if ( ecc > e->inferior ) e->inferior = ecc;
+	if ( 2 * ecc < e->superior ) e->superior = 2 * ecc;
+
+	for ( unsigned int k = 0; k < e->n_cand; k++ ) {
+		unsigned int v = cand[k];
+		long long d = ctx->dist[v];
+		long long inf = d > ecc - d ? d : ecc - d;
+		if ( inf > ecc_inf[v] ) ecc_inf[v] = inf;
+		if ( ecc + d < ecc_sup[v] ) ecc_sup[v] = ecc + d;
+		if ( ecc_inf[v] > e->inferior ) e->inferior = ecc_inf[v];
+	}
+
+	// Descarta quem nao pode passar do limite inferior e recalcula o superior
+	long long max_sup = e->inferior;
+	unsigned int n_cand = 0;
+	for ( unsigned int k = 0; k < e->n_cand; k++ ) {
+		unsigned int v = cand[k];
+		if ( ecc_sup[v] > e->inferior ) {
+			cand[n_cand++] = v;
+			if ( ecc_sup[v] > max_sup ) max_sup = ecc_sup[v];
+		}
+	}
+	e->n_cand = n_cand;
+	if ( max_sup < e->superior ) e->superior = max_sup;
+	if ( n_cand == 0 ) e->superior = e->inferior;
+}
+
+limites_diametro *limites_diametros (grafo *g, unsigned int max_buscas, double max_segundos) {
+	// O prazo conta desde a chamada, preparacao incluida
+	double limite_tempo = max_segundos > 0 ? agora () + max_segundos : 0;
+	const unsigned int *rotulo = rotulos_componentes (g);
+	unsigned int n = g->n_vertices;
+	unsigned int nc = g->n_componentes;
+
+	limites_diametro *res = malloc (sizeof (limites_diametro) * ((size_t)nc + 1));
+	if ( n == 0 || !res ) return res;
+	if ( !rotulo ) {
+		free (res);
+		return NULL;
+	}
+
+	estado_diametro *est = aloca_temporario_zerado (g, nc, sizeof (estado_diametro));
+	unsigned int *membros = aloca_temporario (g, sizeof (unsigned int) * n);
+	long long *ecc_inf = aloca_temporario_zerado (g, n, sizeof (long long));
+	long long *ecc_sup = aloca_temporario (g, sizeof (long long) * n);
+	long long *max_peso = aloca_temporario_zerado (g, nc, sizeof (long long));
+	contexto_busca *ctx = cria_contexto_busca (g);
+	if ( !est || !membros || !ecc_inf || !ecc_sup || !max_peso || !ctx ) {
+		free (res);
+		res = NULL;
+		goto fim;
+	}
+
+	// Agrupa os vertices por componente (ordenacao por contagem dos rotulos)
+	for ( unsigned int c = 1; c < nc; c++ ) {
+		est[c].inicio = est[c - 1].inicio + g->tam_componente[c - 1];
+	}
+	for ( unsigned int i = 0; i < n; i++ ) {
+		estado_diametro *e = &est[rotulo[i]];
+		if ( e->n_cand == 0 ) e->fonte = i;
+		membros[e->inicio + e->n_cand++] = i;
+		ecc_sup[i] = LLONG_MAX;
+
+		unsigned int grau = 0;
+		for ( vizinho *viz = ctx->v_arr[i]->vizinhos; viz; viz = viz->prox ) {
+			long long p = (viz->peso > 0) ? viz->peso : 1;
+			if ( p > max_peso[rotulo[i]] ) max_peso[rotulo[i]] = p;
+			grau++;
+		}
+		e->meias += grau;
+		if ( grau > e->grau_fonte ) {
+			e->fonte = i;
+			e->grau_fonte = grau;
+		}
+	}
+
+	// Limites sem busca: um caminho minimo tem no maximo tam - 1 arestas
+	for ( unsigned int c = 0; c < nc; c++ ) {
+		est[c].inferior = 0;
+		est[c].superior = (long long)(g->tam_componente[c] - 1) * max_peso[c];
+	}
+
+	// Sem orcamento, componentes pequenos e densos saem exatos da matriz de distancias
+	if ( max_buscas == 0 && max_segundos <= 0 ) {
+		for ( unsigned int c = 0; c < nc; c++ ) {
+			estado_diametro *e = &est[c];
+			if ( !usa_matriz_distancias (e->n_cand, e->meias / 2) ) continue;
+
+			unsigned int *ids = malloc (sizeof (unsigned int) * e->n_cand);
+			if ( !ids ) continue;
+			memcpy (ids, &membros[e->inicio], sizeof (unsigned int) * e->n_cand);
+
+			matriz_distancias *m = monta_matriz (ctx->v_arr, ids, e->n_cand);
+			if ( !m ) continue;
+
+			long long diam = 0;
+			for ( unsigned int i = 0; i < m->n; i++ ) {
+				long long ecc = maximo_linha (m, i);
+				if ( ecc > diam ) diam = ecc;
+			}
+			e->inferior = e->superior = diam;
+			destroi_matriz_distancias (m);
+		}
+	}
+
+	// Rodizio entre os componentes ainda abertos, enquanto houver orcamento
+	unsigned int buscas = 0;
+	bool abertos = true;
+	while ( abertos ) {
+		abertos = false;
+		for ( unsigned int c = 0; c < nc; c++ ) {
+			estado_diametro *e = &est[c];
+			if ( e->inferior >= e->superior ) continue;
+
+			if ( (max_buscas && buscas >= max_buscas) || (limite_tempo > 0 && agora () >= limite_tempo) ) {
+				abertos = false;
+				break;
+			}
+
+			refina_diametro (e, membros, ecc_inf, ecc_sup, ctx);
+			buscas++;
+			if ( e->inferior < e->superior ) abertos = true;
+		}
+	}
+
+	for ( unsigned int c = 0; c < nc; c++ ) {
+		res[c].inferior = est[c].inferior > INT_MAX ? INT_MAX : (int)est[c].inferior;
+		res[c].superior = est[c].superior > INT_MAX ? INT_MAX : (int)est[c].superior;
+	}
+
+fim:
+	libera_temporario (g, est);
+	libera_temporario (g, membros);
+	libera_temporario (g, ecc_inf);
+	libera_temporario (g, ecc_sup);
+	libera_temporario (g, max_peso);
+	destroi_contexto_busca (ctx);
+	return res;
+}
+
+// Função principal para calcular os diâmetros dos componentes.
+
+char *diametros (grafo *g) {
+	if ( g->n_vertices == 0 ) return strdup ("");
+
+	// Sem orcamento os limites se encontram: o diametro exato de cada componente
+	limites_diametro *lim = limites_diametros (g, 0, 0);
+	if ( !lim ) return NULL;
+
+	unsigned int n_diams = g->n_componentes;
+	int *diams = malloc (sizeof (int) * n_diams);
+	if ( !diams ) {
+		free (lim);
+		return NULL;
+	}
+	for ( unsigned int c = 0; c < n_diams; c++ ) {
+		diams[c] = lim[c].superior;
+	}
+	free (lim);
+
+	// Ordena os diâmetros
+	qsort (diams, n_diams, sizeof (int), cmp_int);
+
+	// Monta a string de resultado
+	char *res = malloc (12 * (size_t)n_diams + 1);
+	if ( !res ) {
+		free (diams);
+		return NULL;
+	}
+	size_t len = 0;
+	res[0] = '\0';
+	for ( unsigned int i = 0; i < n_diams; i++ ) {
+		len += (size_t)sprintf (res + len, i + 1 < n_diams ? "%d " : "%d", diams[i]);
+	}
+
+	free (diams);
+	return res;
+}
+
+//------------------------------------------------------------------------------
+// centralidades por vertice
+
+#define LOTE_FONTES 16  // fontes pegas de uma vez por uma thread
+
+// Estado compartilhado pelas threads de calcula_centralidades
+typedef struct {
+	grafo *g;
+	const unsigned int *rotulo;
+	const unsigned int *membros;   // vertices agrupados por componente
+	const unsigned int *inicio;    // componente c em membros[inicio[c] .. inicio[c + 1])
+	const bool *amostrado;         // componente estimado por amostragem
+	const unsigned int *fontes;    // origens das buscas
+	unsigned int n_fontes;
+	unsigned int proxima;          // proxima fonte a ser pega
+	pthread_mutex_t trava;
+	centralidade *res;
+	bool erro;
+} estado_centralidade;
+
+// Acumuladores de uma thread para os componentes amostrados
+typedef struct {
+	estado_centralidade *e;
+	double *soma;        // soma das distancias ate as fontes
+	double *harm;        // soma dos inversos das distancias ate as fontes
+	int *ecc;            // maior limite inferior de excentricidade
+	unsigned int *cont;  // fontes (diferentes do vertice) que o alcancaram
+} trabalhador_centralidade;
+
+static void *trabalha_centralidade (void *arg) {
+	trabalhador_centralidade *w = arg;
+	estado_centralidade *e = w->e;
+
+	contexto_busca *ctx = cria_contexto_busca (e->g);
+	if ( !ctx ) {
+		pthread_mutex_lock (&e->trava);
+		e->erro = true;
+		pthread_mutex_unlock (&e->trava);
+		return NULL;
+	}
+
+	for ( ;; ) {
+		pthread_mutex_lock (&e->trava);
+		unsigned int ini = e->proxima;
+		unsigned int fim = e->n_fontes - ini > LOTE_FONTES ? ini + LOTE_FONTES : e->n_fontes;
+		e->proxima = fim;
+		pthread_mutex_unlock (&e->trava);
+		if ( ini >= fim ) break;
+
+		for ( unsigned int k = ini; k < fim; k++ ) {
+			unsigned int s = e->fontes[k];
+			unsigned int c = e->rotulo[s];
+			int ecc = excentricidade (ctx->v_arr[s], ctx);
+
+			double soma = 0, harm = 0;
+			for ( unsigned int i = e->inicio[c]; i < e->inicio[c + 1]; i++ ) {
+				unsigned int v = e->membros[i];
+				int d = ctx->dist[v];
+				soma += d;
+				if ( v == s ) continue;
+				harm += 1.0 / d;
+
+				if ( e->amostrado[c] ) {
+					int lim = d > ecc - d ? d : ecc - d;
+					w->soma[v] += d;
+					w->harm[v] += 1.0 / d;
+					w->cont[v]++;
+					if ( lim > w->ecc[v] ) w->ecc[v] = lim;
+				}
+			}
+
+			// a propria fonte sai exata
+			unsigned int tam = e->inicio[c + 1] - e->inicio[c];
+			e->res[s].excentricidade = ecc;
+			e->res[s].proximidade = soma > 0 ? (tam - 1) / soma : 0;
+			e->res[s].harmonica = harm;
+			e->res[s].aproximada = false;
+		}
+	}
+
+	destroi_contexto_busca (ctx);
+	return NULL;
+}
+
+// Resolve o componente c (exato) pela matriz de distancias
+static bool centralidades_matriz (estado_centralidade *e, vertice **v_arr, unsigned int c) {
+	unsigned int tam = e->inicio[c + 1] - e->inicio[c];
+	unsigned int *ids = malloc (sizeof (unsigned int) * tam);
+	if ( !ids ) return false;
+	memcpy (ids, &e->membros[e->inicio[c]], sizeof (unsigned int) * tam);
+
+	matriz_distancias *m = monta_matriz (v_arr, ids, tam);
+	if ( !m ) return false;
+
+	for ( unsigned int i = 0; i < m->n; i++ ) {
+		const int *linha = &m->dist[(size_t)i * m->passo];
+		double soma = 0, harm = 0;
+		int ecc = 0;
+		for ( unsigned int j = 0; j < m->n; j++ ) {
+			if ( j == i ) continue;
+			soma += linha[j];
+			harm += 1.0 / linha[j];
+			if ( linha[j] > ecc ) ecc = linha[j];
+		}
+		centralidade *r = &e->res[m->ids[i]];
+		r->excentricidade = ecc;
+		r->proximidade = soma > 0 ? (tam - 1) / soma : 0;
+		r->harmonica = harm;
+		r->aproximada = false;
+	}
+
+	destroi_matriz_distancias (m);
+	return true;
+}
+
+// Gerador xorshift para sortear as fontes, com semente fixa (resultado reprodutivel)
+static uint64_t xorshift (uint64_t *x) {
+	*x ^= *x << 13;
+	*x ^= *x >> 7;
+	*x ^= *x << 17;
+	return *x;
+}
+
+centralidade *calcula_centralidades (grafo *g, unsigned int threads, unsigned int amostras) {
+	const unsigned int *rotulo = rotulos_componentes (g);
+	unsigned int n = g->n_vertices;
+	unsigned int nc = g->n_componentes;
+
+	centralidade *res = calloc ((size_t)n + 1, sizeof (centralidade));
+	if ( n == 0 || !res ) return res;
+	if ( !rotulo ) {
+		free (res);
+		return NULL;
+	}
+
+	if ( threads == 0 ) threads = processadores ();
+
+	estado_centralidade e = {0};
+	unsigned int *inicio = aloca_temporario_zerado (g, (size_t)nc + 1, sizeof (unsigned int));
+	unsigned int *membros = aloca_temporario (g, sizeof (unsigned int) * n);
+	unsigned int *fontes = aloca_temporario (g, sizeof (unsigned int) * n);
+	bool *amostrado = aloca_temporario_zerado (g, nc, sizeof (bool));
+	size_t *meias = aloca_temporario_zerado (g, nc, sizeof (size_t));
+	vertice **v_arr = aloca_temporario (g, sizeof (vertice *) * n);
+	trabalhador_centralidade *w = aloca_temporario_zerado (g, threads, sizeof (trabalhador_centralidade));
+	pthread_t *ids = aloca_temporario (g, sizeof (pthread_t) * threads);
+	if ( !inicio || !membros || !fontes || !amostrado || !meias || !v_arr || !w || !ids ) {
+		free (res);
+		res = NULL;
+		goto fim;
+	}
+
+	// Agrupa os vertices por componente
+	montar_vetor_vertices (g, v_arr);
+	for ( unsigned int c = 0; c < nc; c++ ) {
+		inicio[c + 1] = inicio[c] + g->tam_componente[c];
+	}
+	for ( unsigned int i = 0; i < n; i++ ) {
+		unsigned int c = rotulo[i];
+		membros[inicio[c] + meias[c]++] = i;
+	}
+	memset (meias, 0, sizeof (size_t) * nc);
+	for ( unsigned int i = 0; i < n; i++ ) {
+		for ( vizinho *viz = v_arr[i]->vizinhos; viz; viz = viz->prox ) meias[rotulo[i]]++;
+	}
+
+	e.g = g;
+	e.rotulo = rotulo;
+	e.membros = membros;
+	e.inicio = inicio;
+	e.amostrado = amostrado;
+	e.fontes = fontes;
+	e.res = res;
+
+	// Escolhe as fontes: todos os vertices, ou uma amostra nos componentes grandes;
+	// componentes pequenos e densos saem da matriz de distancias
+	uint64_t semente = 0x9e3779b97f4a7c15ULL;
+	for ( unsigned int c = 0; c < nc; c++ ) {
+		unsigned int tam = inicio[c + 1] - inicio[c];
+		const unsigned int *mc = &membros[inicio[c]];
+
+		if ( amostras && tam > amostras ) {
+			amostrado[c] = true;
+			memcpy (&fontes[e.n_fontes], mc, sizeof (unsigned int) * tam);
+			unsigned int *f = &fontes[e.n_fontes];
+			for ( unsigned int k = 0; k < amostras; k++ ) {
+				unsigned int j = k + (unsigned int)(xorshift (&semente) % (tam - k));
+				unsigned int tmp = f[k];
+				f[k] = f[j];
+				f[j] = tmp;
+			}
+			e.n_fontes += amostras;
+		} else if ( usa_matriz_distancias (tam, meias[c] / 2) && centralidades_matriz (&e, v_arr, c) ) {
+			continue;
+		} else {
+			memcpy (&fontes[e.n_fontes], mc, sizeof (unsigned int) * tam);
+			e.n_fontes += tam;
+		}
+	}
+
+	// Acumuladores por thread, so se houver componente amostrado
+	bool algum_amostrado = false;
+	for ( unsigned int c = 0; c < nc; c++ ) algum_amostrado = algum_amostrado || amostrado[c];
+
+	if ( threads > e.n_fontes / LOTE_FONTES + 1 ) threads = e.n_fontes / LOTE_FONTES + 1;
+	for ( unsigned int t = 0; t < threads; t++ ) {
+		w[t].e = &e;
+		if ( !algum_amostrado ) continue;
+		w[t].soma = aloca_temporario_zerado (g, n, sizeof (double));
+		w[t].harm = aloca_temporario_zerado (g, n, sizeof (double));
+		w[t].ecc = aloca_temporario_zerado (g, n, sizeof (int));
+		w[t].cont = aloca_temporario_zerado (g, n, sizeof (unsigned int));
+		if ( !w[t].soma || !w[t].harm || !w[t].ecc || !w[t].cont ) e.erro = true;
+	}
+
+	// A thread que chama tambem trabalha
+	unsigned int criadas = 0;
+	pthread_mutex_init (&e.trava, NULL);
+	if ( !e.erro ) {
+		while ( criadas + 1 < threads && pthread_create (&ids[criadas], NULL, trabalha_centralidade, &w[criadas + 1]) == 0 ) {
+			criadas++;
+		}
+		trabalha_centralidade (&w[0]);
+	}
+	for ( unsigned int t = 0; t < criadas; t++ ) {
+		pthread_join (ids[t], NULL);
+	}
+	pthread_mutex_destroy (&e.trava);
+
+	if ( e.erro ) {
+		free (res);
+		res = NULL;
+		goto fim;
+	}
+
+	// Estimativas dos vertices que nao foram fonte nos componentes amostrados:
+	// media das distancias ate as fontes e maior limite inferior de excentricidade
+	for ( unsigned int c = 0; c < nc; c++ ) {
+		if ( !amostrado[c] ) continue;
+		unsigned int tam = inicio[c + 1] - inicio[c];
+
+		for ( unsigned int i = inicio[c]; i < inicio[c + 1]; i++ ) {
+			unsigned int v = membros[i];
+			double soma = 0, harm = 0;
+			unsigned int cont = 0;
+			int ecc = 0;
+			for ( unsigned int t = 0; t < threads; t++ ) {
+				soma += w[t].soma[v];
+				harm += w[t].harm[v];
+				cont += w[t].cont[v];
+				if ( w[t].ecc[v] > ecc ) ecc = w[t].ecc[v];
+			}
+
+			// fontes ja tem o valor exato (e cont < amostras)
+			if ( cont < amostras ) continue;
+
+			res[v].excentricidade = ecc;
+			res[v].proximidade = soma > 0 ? cont / soma : 0;
+			res[v].harmonica = harm * (tam - 1) / cont;
+			res[v].aproximada = true;
+		}
+	}
+
+fim:
+	if ( w ) {
+		for ( unsigned int t = 0; t < threads; t++ ) {
+			libera_temporario (g, w[t].soma);
+			libera_temporario (g, w[t].harm);
+			libera_temporario (g, w[t].ecc);
+			libera_temporario (g, w[t].cont);
+		}
+	}
+	libera_temporario (g, w);
+	libera_temporario (g, ids);
+	libera_temporario (g, inicio);
+	libera_temporario (g, membros);
+	libera_temporario (g, fontes);
+	libera_temporario (g, amostrado);
+	libera_temporario (g, meias);
+	libera_temporario (g, v_arr);
+	return res;
+}
+
+static int cmp_vertice_nome (const void *a, const void *b) {
+	return strcmp ((*(vertice * const *)a)->nome, (*(vertice * const *)b)->nome);
+}
+
+bool escreve_centralidades (grafo *g, FILE *saida, unsigned int threads, unsigned int amostras) {
+	centralidade *c = calcula_centralidades (g, threads, amostras);
+	vertice **v_arr = malloc (sizeof (vertice *) * ((size_t)g->n_vertices + 1));
+	if ( !c || !v_arr ) {
+		free (c);
+		free (v_arr);
+		return false;
+	}
+
+	montar_vetor_vertices (g, v_arr);
+	qsort (v_arr, g->n_vertices, sizeof (vertice *), cmp_vertice_nome);
+
+	bool ok = true;
+	for ( unsigned int i = 0; i < g->n_vertices && ok; i++ ) {
+		const centralidade *r = &c[v_arr[i]->id];
+		ok = fprintf (saida, "%s %d %.6f %.6f%s\n", v_arr[i]->nome, r->excentricidade,
+			r->proximidade, r->harmonica, r->aproximada ? " ~" : "") >= 0;
+	}
+
+	free (c);
+	free (v_arr);
+	return ok;
+}
+
+// Monta em *inicio / *viz os vizinhos distintos de cada id, sem lacos (arestas paralelas
+// contam uma vez): os de v ficam em (*viz)[(*inicio)[v] .. (*inicio)[v + 1])
+static bool vizinhos_distintos (grafo *g, size_t **inicio, unsigned int **viz) {
+	unsigned int n = g->n_vertices;
+	size_t meias = 0;
+	for ( vertice *v = g->vertices; v; v = v->prox ) {
+		for ( vizinho *x = v->vizinhos; x; x = x->prox ) meias++;
+	}
+
+	vertice **v_arr = aloca_temporario (g, sizeof (vertice *) * ((size_t)n + 1));
+	unsigned int *marca = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	*inicio = aloca_temporario (g, sizeof (size_t) * ((size_t)n + 1));
+	*viz = aloca_temporario (g, sizeof (unsigned int) * (meias + 1));
+	if ( !v_arr || !marca || !*inicio || !*viz ) {
+		libera_temporario (g, v_arr);
+		libera_temporario (g, marca);
+		libera_temporario (g, *inicio);
+		libera_temporario (g, *viz);
+		*inicio = NULL;
+		*viz = NULL;
+		return false;
+	}
+
+	montar_vetor_vertices (g, v_arr);
+	memset (marca, 0xff, sizeof (unsigned int) * n);
+	(*inicio)[0] = 0;
+	for ( unsigned int v = 0; v < n; v++ ) {
+		size_t k = (*inicio)[v];
+		for ( vizinho *x = v_arr[v]->vizinhos; x; x = x->prox ) {
+			unsigned int w = x->destino->id;
+			if ( w == v || marca[w] == v ) continue;
+			marca[w] = v;
+			(*viz)[k++] = w;
+		}
+		(*inicio)[v + 1] = k;
+	}
+
+	libera_temporario (g, v_arr);
+	libera_temporario (g, marca);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// triangulos e coeficientes de agrupamento
+
+#define LOTE_TRIANGULOS 64  // vertices pegos de uma vez por uma thread
+#define GRAU_MAPA 32        // a partir desse grau para frente a intersecao usa o mapa de bits
+
+// Estado compartilhado pelas threads de calcula_agrupamento; os vertices sao
+// identificados pela posicao na ordem crescente de grau
+typedef struct {
+	unsigned int n;
+	const size_t *inicio;        // vizinhos de u para frente em frente[inicio[u] .. inicio[u + 1])
+	const unsigned int *frente;  // posicoes maiores que u, em ordem crescente
+	unsigned int proximo;        // proximo vertice a ser pego
+	pthread_mutex_t trava;
+} estado_triangulos;
+
+// Contadores de uma thread
+typedef struct {
+	estado_triangulos *e;
+	unsigned long long *cont;    // triangulos de cada posicao achados por esta thread
+	uint64_t *mapa;              // mapa de bits de n posicoes, zerado entre usos
+} trabalhador_triangulos;
+
+#if defined (LARGURA_VETOR)
+// 4 posicoes de uma vez, na intersecao em blocos
+typedef unsigned int vetor_id __attribute__ ((vector_size (16)));
+
+// Intersecao das listas ordenadas (sem repeticoes) [*a, fa) e [*b, fb) em blocos de 4:
+// o bloco de a e comparado de uma vez com cada elemento do bloco de b, e anda o bloco que
+// termina antes (os dois, se terminam no mesmo). Para quando uma lista tem menos de um
+// bloco, deixando *a e *b no ponto em que a intercalacao continua; conta os comuns em
+// cont e devolve quantos sao
+static unsigned long long intersecao_blocos (const unsigned int **a, const unsigned int *fa, const unsigned int **b, const unsigned int *fb, unsigned long long *cont) {
+	const unsigned int *x = *a, *y = *b;
+	unsigned long long t = 0;
+
+	while ( fa - x >= LARGURA_VETOR && fb - y >= LARGURA_VETOR ) {
+		vetor_id vx;
+		memcpy (&vx, x, sizeof (vx));
+		vetor_id igual = (vx == (vetor_id){y[0], y[0], y[0], y[0]}) | (vx == (vetor_id){y[1], y[1], y[1], y[1]})
+			| (vx == (vetor_id){y[2], y[2], y[2], y[2]}) | (vx == (vetor_id){y[3], y[3], y[3], y[3]});
+		if ( igual[0] | igual[1] | igual[2] | igual[3] ) {
+			for ( unsigned int i = 0; i < LARGURA_VETOR; i++ ) {
+				if ( igual[i] ) {
+					cont[x[i]]++;
+					t++;
+				}
+			}
+		}
+
+		unsigned int ultimo_x = x[LARGURA_VETOR - 1], ultimo_y = y[LARGURA_VETOR - 1];
+		if ( ultimo_x <= ultimo_y ) x += LARGURA_VETOR;
+		if ( ultimo_y <= ultimo_x ) y += LARGURA_VETOR;
+	}
+
+	*a = x;
+	*b = y;
+	return t;
+}
+#endif
+
+// Cada triangulo u < v < w e achado uma so vez, a partir de u: w esta nas duas listas
+// para frente, de u e de v. Listas longas de u viram mapa de bits, percorrido pela de v
+static void *trabalha_triangulos (void *arg) {
+	trabalhador_triangulos *w = arg;
+	estado_triangulos *e = w->e;
+	const size_t *inicio = e->inicio;
+	const unsigned int *frente = e->frente;
+	unsigned long long *cont = w->cont;
+
+	for ( ;; ) {
+		pthread_mutex_lock (&e->trava);
+		unsigned int ini = e->proximo;
+		unsigned int fim = e->n - ini > LOTE_TRIANGULOS ? ini + LOTE_TRIANGULOS : e->n;
+		e->proximo = fim;
+		pthread_mutex_unlock (&e->trava);
+		if ( ini >= fim ) break;
+
+		for ( unsigned int u = ini; u < fim; u++ ) {
+			size_t a0 = inicio[u], a1 = inicio[u + 1];
+			bool mapa = a1 - a0 >= GRAU_MAPA;
+
+			if ( mapa ) {
+				for ( size_t k = a0; k < a1; k++ ) w->mapa[frente[k] / 64] |= (uint64_t)1 << (frente[k] % 64);
+			}
+
+			unsigned long long t_u = 0;
+			for ( size_t k = a0; k < a1; k++ ) {
+				unsigned int v = frente[k];
+				unsigned long long t_v = 0;
+
+				if ( mapa ) {
+					for ( size_t j = inicio[v]; j < inicio[v + 1]; j++ ) {
+						unsigned int x = frente[j];
+						if ( w->mapa[x / 64] >> (x % 64) & 1 ) {
+							cont[x]++;
+							t_v++;
+						}
+					}
+				} else {
+					// intersecao por intercalacao; em u so interessam os maiores que v
+					const unsigned int *a = &frente[k + 1], *fa = &frente[a1];
+					const unsigned int *b = &frente[inicio[v]], *fb = &frente[inicio[v + 1]];
+#if defined (LARGURA_VETOR)
+					t_v = intersecao_blocos (&a, fa, &b, fb, cont);
+#endif
+					while ( a < fa && b < fb ) {
+						if ( *a < *b ) a++;
+						else if ( *a > *b ) b++;
+						else {
+							cont[*a]++;
+							t_v++;
+							a++;
+							b++;
+						}
+					}
+				}
+
+				cont[v] += t_v;
+				t_u += t_v;
+			}
+			cont[u] += t_u;
+
+			if ( mapa ) {
+				for ( size_t k = a0; k < a1; k++ ) w->mapa[frente[k] / 64] = 0;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+void destroi_agrupamento (agrupamento *a) {
+	if ( !a ) return;
+
+	free (a->por_vertice);
+	free (a->local);
+	free (a);
+}
+
+agrupamento *calcula_agrupamento (grafo *g, unsigned int threads) {
+	unsigned int n = g->n_vertices;
+
+	if ( threads == 0 ) threads = processadores ();
+	if ( threads > n / LOTE_TRIANGULOS + 1 ) threads = n / LOTE_TRIANGULOS + 1;
+
+	size_t *ini_viz = NULL;
+	unsigned int *viz_id = NULL;
+	bool erro = !vizinhos_distintos (g, &ini_viz, &viz_id);
+	size_t arestas = erro ? 0 : ini_viz[n] / 2;
+
+	agrupamento *res = calloc (1, sizeof (agrupamento));
+	unsigned int *ordem = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	unsigned int *pos = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	size_t *inicio = aloca_temporario_zerado (g, (size_t)n + 2, sizeof (size_t));
+	unsigned int *frente = aloca_temporario (g, sizeof (unsigned int) * (arestas + 1));
+	trabalhador_triangulos *w = aloca_temporario_zerado (g, threads, sizeof (trabalhador_triangulos));
+	pthread_t *ids = aloca_temporario (g, sizeof (pthread_t) * threads);
+	if ( res ) {
+		res->por_vertice = calloc ((size_t)n + 1, sizeof (unsigned long long));
+		res->local = calloc ((size_t)n + 1, sizeof (double));
+	}
+	erro = erro || !res || !res->por_vertice || !res->local || !ordem || !pos || !inicio || !frente
+		|| !w || !ids;
+	if ( erro ) goto fim;
+
+	// Ordem crescente de grau (contagem, estavel nos ids)
+	unsigned int grau_max = 0;
+	for ( unsigned int v = 0; v < n; v++ ) {
+		unsigned int grau = (unsigned int)(ini_viz[v + 1] - ini_viz[v]);
+		if ( grau > grau_max ) grau_max = grau;
+	}
+	unsigned int *balde = aloca_temporario_zerado (g, (size_t)grau_max + 2, sizeof (unsigned int));
+	if ( !balde ) {
+		erro = true;
+		goto fim;
+	}
+	for ( unsigned int v = 0; v < n; v++ ) balde[ini_viz[v + 1] - ini_viz[v] + 1]++;
+	for ( unsigned int d = 0; d < grau_max; d++ ) balde[d + 1] += balde[d];
+	for ( unsigned int v = 0; v < n; v++ ) {
+		unsigned int r = balde[ini_viz[v + 1] - ini_viz[v]]++;
+		ordem[r] = v;
+		pos[v] = r;
+	}
+	libera_temporario (g, balde);
+
+	// Cada aresta aponta para a ponta de maior posicao; percorrendo as pontas em ordem
+	// crescente, as listas para frente ja saem ordenadas
+	for ( unsigned int v = 0; v < n; v++ ) {
+		for ( size_t k = ini_viz[v]; k < ini_viz[v + 1]; k++ ) {
+			if ( pos[viz_id[k]] > pos[v] ) inicio[pos[v] + 2]++;
+		}
+	}
+	for ( unsigned int r = 0; r < n; r++ ) inicio[r + 2] += inicio[r + 1];
+	for ( unsigned int r = 0; r < n; r++ ) {
+		unsigned int v = ordem[r];
+		for ( size_t k = ini_viz[v]; k < ini_viz[v + 1]; k++ ) {
+			unsigned int x = pos[viz_id[k]];
+			if ( x < r ) frente[inicio[x + 1]++] = r;
+		}
+	}
+
+	estado_triangulos e = {0};
+	e.n = n;
+	e.inicio = inicio;
+	e.frente = frente;
+
+	for ( unsigned int t = 0; t < threads; t++ ) {
+		w[t].e = &e;
+		w[t].cont = aloca_temporario_zerado (g, (size_t)n + 1, sizeof (unsigned long long));
+		w[t].mapa = aloca_temporario_zerado (g, (size_t)n / 64 + 1, sizeof (uint64_t));
+		if ( !w[t].cont || !w[t].mapa ) erro = true;
+	}
+	if ( erro ) goto fim;
+
+	// A thread que chama tambem trabalha
+	unsigned int criadas = 0;
+	pthread_mutex_init (&e.trava, NULL);
+	while ( criadas + 1 < threads && pthread_create (&ids[criadas], NULL, trabalha_triangulos, &w[criadas + 1]) == 0 ) {
+		criadas++;
+	}
+	trabalha_triangulos (&w[0]);
+	for ( unsigned int t = 0; t < criadas; t++ ) {
+		pthread_join (ids[t], NULL);
+	}
+	pthread_mutex_destroy (&e.trava);
+
+	// Cada triangulo foi contado nos seus tres vertices
+	unsigned long long soma = 0;
+	double caminhos = 0, soma_local = 0;
+	for ( unsigned int r = 0; r < n; r++ ) {
+		unsigned int v = ordem[r];
+		unsigned long long t_v = 0;
+		for ( unsigned int t = 0; t < threads; t++ ) t_v += w[t].cont[r];
+
+		double grau = (double)(ini_viz[v + 1] - ini_viz[v]);
+		double pares = grau * (grau - 1) / 2;
+		res->por_vertice[v] = t_v;
+		res->local[v] = pares > 0 ? (double)t_v / pares : 0;
+		soma += t_v;
+		caminhos += pares;
+		soma_local += res->local[v];
+	}
+	res->triangulos = soma / 3;
+	res->global = caminhos > 0 ? (double)soma / caminhos : 0;
+	res->medio = n > 0 ? soma_local / n : 0;
+
+fim:
+	if ( w ) {
+		for ( unsigned int t = 0; t < threads; t++ ) {
+			libera_temporario (g, w[t].cont);
+			libera_temporario (g, w[t].mapa);
+		}
+	}
+	libera_temporario (g, w);
+	libera_temporario (g, ids);
+	libera_temporario (g, ini_viz);
+	libera_temporario (g, viz_id);
+	libera_temporario (g, ordem);
+	libera_temporario (g, pos);
+	libera_temporario (g, inicio);
+	libera_temporario (g, frente);
+	if ( erro ) {
+		destroi_agrupamento (res);
+		return NULL;
+	}
+	return res;
+}
+
+bool escreve_agrupamento (grafo *g, FILE *saida, unsigned int threads) {
+	agrupamento *a = calcula_agrupamento (g, threads);
+	vertice **v_arr = malloc (sizeof (vertice *) * ((size_t)g->n_vertices + 1));
+	if ( !a || !v_arr ) {
+		destroi_agrupamento (a);
+		free (v_arr);
+		return false;
+	}
+
+	montar_vetor_vertices (g, v_arr);
+	qsort (v_arr, g->n_vertices, sizeof (vertice *), cmp_vertice_nome);
+
+	bool ok = fprintf (saida, "triangulos: %llu global: %.6f medio: %.6f\n", a->triangulos,
+		a->global, a->medio) >= 0;
+	for ( unsigned int i = 0; i < g->n_vertices && ok; i++ ) {
+		unsigned int id = v_arr[i]->id;
+		ok = fprintf (saida, "%s %llu %.6f\n", v_arr[i]->nome, a->por_vertice[id], a->local[id]) >= 0;
+	}
+
+	destroi_agrupamento (a);
+	free (v_arr);
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// decomposicao em k-nucleos
+
+void destroi_nucleos (nucleos *k) {
+	if ( !k ) return;
+
+	free (k->nucleo);
+	free (k);
+}
+
+// Aloca o resultado e a adjacencia sem lacos nem repeticoes usada pelas duas versoes
+static nucleos *prepara_nucleos (grafo *g, size_t **inicio, unsigned int **viz) {
+	nucleos *k = calloc (1, sizeof (nucleos));
+	if ( k ) k->nucleo = malloc (sizeof (unsigned int) * ((size_t)g->n_vertices + 1));
+	if ( !k || !k->nucleo || !vizinhos_distintos (g, inicio, viz) ) {
+		destroi_nucleos (k);
+		return NULL;
+	}
+	return k;
+}
+
+nucleos *k_cores (grafo *g) {
+	unsigned int n = g->n_vertices;
+	size_t *inicio;
+	unsigned int *viz;
+	nucleos *res = prepara_nucleos (g, &inicio, &viz);
+	if ( !res ) return NULL;
+
+	// Batagelj-Zaversnik: vert em ordem crescente de grau, balde[d] = primeira posicao
+	// de grau d, pos[v] = posicao de v em vert
+	unsigned int *grau = res->nucleo;
+	unsigned int grau_max = 0;
+	for ( unsigned int v = 0; v < n; v++ ) {
+		grau[v] = (unsigned int)(inicio[v + 1] - inicio[v]);
+		if ( grau[v] > grau_max ) grau_max = grau[v];
+	}
+
+	unsigned int *balde = aloca_temporario_zerado (g, (size_t)grau_max + 2, sizeof (unsigned int));
+	unsigned int *vert = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	unsigned int *pos = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	if ( !balde || !vert || !pos ) {
+		destroi_nucleos (res);
+		res = NULL;
+		goto fim;
+	}
+
+	for ( unsigned int v = 0; v < n; v++ ) balde[grau[v] + 1]++;
+	for ( unsigned int d = 0; d < grau_max; d++ ) balde[d + 1] += balde[d];
+	for ( unsigned int v = 0; v < n; v++ ) {
+		pos[v] = balde[grau[v]]++;
+		vert[pos[v]] = v;
+	}
+	for ( unsigned int d = grau_max; d > 0; d-- ) balde[d] = balde[d - 1];
+	balde[0] = 0;
+
+	// Tira sempre o vertice de menor grau; cada vizinho de grau maior desce um balde,
+	// trocando de lugar com o primeiro do seu balde
+	for ( unsigned int i = 0; i < n; i++ ) {
+		unsigned int v = vert[i];
+		for ( size_t k = inicio[v]; k < inicio[v + 1]; k++ ) {
+			unsigned int u = viz[k];
+			if ( grau[u] <= grau[v] ) continue;
+
+			unsigned int pu = pos[u], pw = balde[grau[u]];
+			unsigned int w = vert[pw];
+			if ( u != w ) {
+				vert[pu] = w;
+				pos[w] = pu;
+				vert[pw] = u;
+				pos[u] = pw;
+			}
+			balde[grau[u]]++;
+			grau[u]--;
+		}
+		if ( grau[v] > res->degeneracao ) res->degeneracao = grau[v];
+	}
+
+fim:
+	libera_temporario (g, balde);
+	libera_temporario (g, vert);
+	libera_temporario (g, pos);
+	libera_temporario (g, inicio);
+	libera_temporario (g, viz);
+	return res;
+}
+
+// Estado compartilhado pelas threads de k_cores_paralelo
+typedef struct {
+	unsigned int n;
+	const size_t *inicio;
+	const unsigned int *viz;
+	unsigned int *grau;          // grau restante, decrementado atomicamente
+	unsigned int *nucleo;        // UINT_MAX enquanto o vertice nao saiu
+	unsigned int threads;
+	size_t *tam;                 // tamanho da fronteira de cada thread na rodada
+	pthread_mutex_t partida;     // segura as threads ate todas terem sido criadas
+	pthread_barrier_t barreira;
+} estado_nucleos;
+
+typedef struct {
+	estado_nucleos *e;
+	unsigned int id;
+	unsigned int *fila;          // fronteira da rodada
+	unsigned int *proxima;       // vertices que cairam para o nivel na rodada
+} trabalhador_nucleos;
+
+// Descascamento por niveis: no nivel k saem os vertices de grau k; tirar um vertice
+// decrementa os vizinhos de grau maior que k, e os que chegam a k saem na rodada
+// seguinte. Cada thread varre sua faixa de ids e cuida da sua fronteira
+static void *trabalha_nucleos (void *arg) {
+	trabalhador_nucleos *w = arg;
+	estado_nucleos *e = w->e;
+
+	pthread_mutex_lock (&e->partida);
+	pthread_mutex_unlock (&e->partida);
+
+	unsigned int ini = (unsigned int)((unsigned long long)e->n * w->id / e->threads);
+	unsigned int fim = (unsigned int)((unsigned long long)e->n * (w->id + 1) / e->threads);
+	size_t removidos = 0;
+
+	for ( unsigned int k = 0; removidos < e->n; k++ ) {
+		size_t tam = 0;
+		for ( unsigned int v = ini; v < fim; v++ ) {
+			if ( e->nucleo[v] == UINT_MAX && e->grau[v] == k ) {
+				e->nucleo[v] = k;
+				w->fila[tam++] = v;
+			}
+		}
+
+		for ( ;; ) {
+			// todas as threads somam as mesmas fronteiras e decidem juntas
+			e->tam[w->id] = tam;
+			pthread_barrier_wait (&e->barreira);
+			size_t total = 0;
+			for ( unsigned int t = 0; t < e->threads; t++ ) total += e->tam[t];
+			pthread_barrier_wait (&e->barreira);
+			if ( total == 0 ) break;
+			removidos += total;
+
+			size_t prox = 0;
+			for ( size_t i = 0; i < tam; i++ ) {
+				unsigned int v = w->fila[i];
+				for ( size_t j = e->inicio[v]; j < e->inicio[v + 1]; j++ ) {
+					unsigned int u = e->viz[j];
+					if ( __atomic_load_n (&e->grau[u], __ATOMIC_RELAXED) <= k ) continue;
+
+					// so quem leva u de k + 1 a k o coloca na fronteira; quem passa
+					// do ponto devolve o que tirou
+					unsigned int d = __atomic_sub_fetch (&e->grau[u], 1, __ATOMIC_RELAXED);
+					if ( d == k ) {
+						e->nucleo[u] = k;
+						w->proxima[prox++] = u;
+					} else if ( d < k ) {
+						__atomic_add_fetch (&e->grau[u], 1, __ATOMIC_RELAXED);
+					}
+				}
+			}
+
+			unsigned int *tmp = w->fila;
+			w->fila = w->proxima;
+			w->proxima = tmp;
+			tam = prox;
+		}
+	}
+
+	return NULL;
+}
+
+nucleos *k_cores_paralelo (grafo *g, unsigned int threads) {
+	unsigned int n = g->n_vertices;
+	size_t *inicio;
+	unsigned int *viz;
+	nucleos *res = prepara_nucleos (g, &inicio, &viz);
+	if ( !res ) return NULL;
+
+	if ( threads == 0 ) threads = processadores ();
+	if ( threads > n ) threads = n ? n : 1;
+
+	estado_nucleos e = {0};
+	e.n = n;
+	e.inicio = inicio;
+	e.viz = viz;
+	e.nucleo = res->nucleo;
+	e.grau = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.tam = aloca_temporario_zerado (g, threads, sizeof (size_t));
+	trabalhador_nucleos *w = aloca_temporario_zerado (g, threads, sizeof (trabalhador_nucleos));
+	pthread_t *ids = aloca_temporario (g, sizeof (pthread_t) * threads);
+	bool erro = !e.grau || !e.tam || !w || !ids;
+	for ( unsigned int t = 0; t < threads && !erro; t++ ) {
+		// a fronteira de uma thread nunca passa de n vertices
+		w[t].e = &e;
+		w[t].id = t;
+		w[t].fila = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+		w[t].proxima = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+		erro = !w[t].fila || !w[t].proxima;
+	}
+	if ( erro ) goto fim;
+
+	for ( unsigned int v = 0; v < n; v++ ) {
+		e.grau[v] = (unsigned int)(inicio[v + 1] - inicio[v]);
+		e.nucleo[v] = UINT_MAX;
+	}
+
+	// A barreira precisa saber quantas threads existem de fato: as criadas esperam
+	// em partida ate a contagem estar certa. A thread que chama tambem trabalha
+	unsigned int criadas = 0;
+	pthread_mutex_init (&e.partida, NULL);
+	pthread_mutex_lock (&e.partida);
+	while ( criadas + 1 < threads && pthread_create (&ids[criadas], NULL, trabalha_nucleos, &w[criadas + 1]) == 0 ) {
+		criadas++;
+	}
+	e.threads = criadas + 1;
+	pthread_barrier_init (&e.barreira, NULL, e.threads);
+	pthread_mutex_unlock (&e.partida);
+
+	trabalha_nucleos (&w[0]);
+	for ( unsigned int t = 0; t < criadas; t++ ) {
+		pthread_join (ids[t], NULL);
+	}
+	pthread_barrier_destroy (&e.barreira);
+	pthread_mutex_destroy (&e.partida);
+
+	for ( unsigned int v = 0; v < n; v++ ) {
+		if ( res->nucleo[v] > res->degeneracao ) res->degeneracao = res->nucleo[v];
+	}
+
+fim:
+	if ( w ) {
+		for ( unsigned int t = 0; t < threads; t++ ) {
+			libera_temporario (g, w[t].fila);
+			libera_temporario (g, w[t].proxima);
+		}
+	}
+	libera_temporario (g, w);
+	libera_temporario (g, ids);
+	libera_temporario (g, e.grau);
+	libera_temporario (g, e.tam);
+	libera_temporario (g, inicio);
+	libera_temporario (g, viz);
+	if ( erro ) {
+		destroi_nucleos (res);
+		return NULL;
+	}
+	return res;
+}
+
+//------------------------------------------------------------------------------
+// floresta geradora minima
+
+#define BITS_DIGITO 8
+#define DIGITOS (1u << BITS_DIGITO)
+
+// Uma passada da ordenacao por digitos, dividida entre as threads: cada uma conta os
+// digitos do seu pedaco e depois espalha o pedaco a partir das suas posicoes
+typedef struct {
+	const uint64_t *de;
+	uint64_t *para;
+	size_t ini, fim;             // pedaco desta thread
+	unsigned int desloc;         // bits abaixo do digito
+	size_t cont[DIGITOS];        // contagem, depois primeira posicao de cada digito
+} pedaco_radix;
+
+static void *conta_radix (void *arg) {
+	pedaco_radix *p = arg;
+	memset (p->cont, 0, sizeof (p->cont));
+	for ( size_t i = p->ini; i < p->fim; i++ ) p->cont[(p->de[i] >> p->desloc) & (DIGITOS - 1)]++;
+	return NULL;
+}
+
+static void *espalha_radix (void *arg) {
+	pedaco_radix *p = arg;
+	for ( size_t i = p->ini; i < p->fim; i++ ) p->para[p->cont[(p->de[i] >> p->desloc) & (DIGITOS - 1)]++] = p->de[i];
+	return NULL;
+}
+
+// Ordena v (m chaves) pelos 32 bits de cima, estavel, usando aux do mesmo tamanho;
+// devolve o vetor onde ficou o resultado. Digitos iguais em todas as chaves sao pulados
+static uint64_t *ordena_radix (uint64_t *v, uint64_t *aux, size_t m, pedaco_radix *p, unsigned int threads) {
+	for ( unsigned int t = 0; t < threads; t++ ) {
+		p[t].ini = m * t / threads;
+		p[t].fim = m * (t + 1) / threads;
+	}
+
+	for ( unsigned int desloc = 32; desloc < 64; desloc += BITS_DIGITO ) {
+		for ( unsigned int t = 0; t < threads; t++ ) {
+			p[t].de = v;
+			p[t].para = aux;
+			p[t].desloc = desloc;
+		}
+		em_paralelo (conta_radix, p, sizeof (pedaco_radix), threads);
+
+		// Posicoes: digito a digito, e dentro do digito na ordem das threads
+		size_t pos = 0;
+		bool pula = false;
+		for ( unsigned int d = 0; d < DIGITOS; d++ ) {
+			size_t tot = 0;
+			for ( unsigned int t = 0; t < threads; t++ ) {
+				size_t c = p[t].cont[d];
+				p[t].cont[d] = pos + tot;
+				tot += c;
+			}
+			if ( tot == m ) pula = true;
+			pos += tot;
+		}
+		if ( pula ) continue;
+
+		em_paralelo (espalha_radix, p, sizeof (pedaco_radix), threads);
+		uint64_t *tmp = v;
+		v = aux;
+		aux = tmp;
+	}
+
+	return v;
+}
+
+char *floresta_geradora_minima (grafo *g, long long *peso, unsigned int threads) {
+	unsigned int n = g->n_vertices;
+	size_t m = 0;
+	for ( vertice *v = g->vertices; v; v = v->prox ) {
+		for ( vizinho *viz = v->vizinhos; viz; viz = viz->prox ) {
+			if ( v->id < viz->destino->id ) m++;
+		}
+	}
+
+	if ( threads == 0 ) threads = processadores ();
+	// pedacos muito pequenos nao pagam a criacao das threads
+	if ( threads > m / 65536 + 1 ) threads = (unsigned int)(m / 65536 + 1);
+
+	// Chave: peso ajustado (como em excentricidade) nos 32 bits de cima, indice da aresta
+	// nos de baixo
+	uint64_t *chave = aloca_temporario (g, sizeof (uint64_t) * (m + 1));
+	uint64_t *aux = aloca_temporario (g, sizeof (uint64_t) * (m + 1));
+	vizinho **aresta = aloca_temporario (g, sizeof (vizinho *) * (m + 1));
+	vertice **origem = aloca_temporario (g, sizeof (vertice *) * (m + 1));
+	unsigned int *pai = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	pedaco_radix *p = aloca_temporario (g, sizeof (pedaco_radix) * threads);
+	unsigned int total = 0;
+	unsigned int capacidade = n > 1 ? n - 1 : 1;
+	char **arestas = NULL;
+	char *resultado = NULL;
+	if ( !chave || !aux || !aresta || !origem || !pai || !p || !inicializar_arestas (&arestas, capacidade) ) goto fim;
+
+	size_t k = 0;
+	for ( vertice *v = g->vertices; v; v = v->prox ) {
+		for ( vizinho *viz = v->vizinhos; viz; viz = viz->prox ) {
+			if ( v->id >= viz->destino->id ) continue;
+			uint32_t w = (uint32_t)(viz->peso > 0 ? viz->peso : 1);
+			chave[k] = (uint64_t)w << 32 | k;
+			aresta[k] = viz;
+			origem[k] = v;
+			k++;
+		}
+	}
+
+	uint64_t *ordem = ordena_radix (chave, aux, m, p, threads);
+
+	// Kruskal: arestas em ordem crescente de peso, mantidas se ligam arvores diferentes
+	for ( unsigned int i = 0; i < n; i++ ) pai[i] = i;
+	long long soma = 0;
+	for ( size_t i = 0; i < m && total + 1 < n; i++ ) {
+		size_t e = (size_t)(ordem[i] & 0xffffffffu);
+		unsigned int a = uf_raiz (pai, origem[e]->id);
+		unsigned int b = uf_raiz (pai, aresta[e]->destino->id);
+		if ( a == b ) continue;
+
+		pai[a] = b;
+		soma += (long long)(ordem[i] >> 32);
+		if ( !adicionar_aresta_corte (origem[e]->nome, aresta[e]->destino->nome, &arestas, &total, &capacidade) ) goto fim;
+	}
+
+	resultado = montar_string_arestas_corte (arestas, total);
+	if ( resultado && peso ) *peso = soma;
+
+fim:
+	if ( arestas ) destruir_arestas (arestas, total);
+	libera_temporario (g, chave);
+	libera_temporario (g, aux);
+	libera_temporario (g, aresta);
+	libera_temporario (g, origem);
+	libera_temporario (g, pai);
+	libera_temporario (g, p);
+	return resultado;
+}
+
+// Ordena os nomes alfabeticamente
+int cmpstr (const void *a, const void *b) {
+	const char *const *pa = (const char *const *)a;
+	const char *const *pb = (const char *const *)b;
+	return strcmp (*pa, *pb);
+}
+
+bool montar_vetor_vertices (grafo *g, vertice **v_arr) {
+	if ( !v_arr ) return false;
+
+	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
+		v_arr[v->id] = v;	 // insere no vetor, na posicao do id
+	}
+
+	return true;
+}
+
+bool inicializar_vetores (int **desc, int **low, int **pai, bool **articulacao, unsigned int n) {
+	*desc = malloc (sizeof (int) * n);
+	*low = malloc (sizeof (int) * n);
+	*pai = malloc (sizeof (int) * n);
+	*articulacao = malloc (sizeof (bool) * n);
+
+	if ( !*desc || !*low || !*pai || !*articulacao ) {
+		free (*desc);
+		free (*low);
+		free (*pai);
+		free (*articulacao);
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < n; i++ ) {
+		(*desc)[i] = -1;
+		(*low)[i] = -1;
+		(*pai)[i] = -1;
+		(*articulacao)[i] = false;
+	}
+
+	return true;
+}
+
+char *montar_string_vertices_corte (vertice **v_arr, bool *articulacao, unsigned int n) {
+	// Conta quantos vertices sao de corte
+	unsigned int total = 0;
+	for ( unsigned int i = 0; i < n; i++ ) {
+		if ( articulacao[i] ) total++;
+	}
+
+	if ( total == 0 ) {
+		return strdup ("");	 // Nao ha vertices de corte
+	}
+
+	// Coleta nomes dos vertices de corte
+	char **nomes = malloc (sizeof (char *) * total);
+	if ( !nomes ) return NULL;
+
+	unsigned int j = 0;
+	for ( unsigned int i = 0; i < n; i++ ) {
+		if ( articulacao[i] ) {
+			nomes[j++] = v_arr[i]->nome;
+		}
+	}
+
+	qsort (nomes, total, sizeof (char *), cmpstr);
+
+	// Calcula tamanho total da string
+	size_t total_len = 0;
+	for ( unsigned int i = 0; i < total; i++ ) {
+		total_len += strlen (nomes[i]) + 1;	 // +1 para espaco ou '\0'
+	}
+
+	// Monta string final
+	char *resultado = malloc (total_len);
+	if ( !resultado ) {
+		free (nomes);
+		return NULL;
+	}
+
+	resultado[0] = '\0';
+	for ( unsigned int i = 0; i < total; i++ ) {
+		strcat (resultado, nomes[i]);
+		if ( i < total - 1 ) strcat (resultado, " ");
+	}
+
+	free (nomes);
+	return resultado;
+}
+
+void destruir_vetor_vertices (vertice **v_arr) {
+	free (v_arr);
+}
+
+void destruir_vetores_auxiliares (int *desc, int *low, int *pai, bool *articulacao) {
+	free (desc);
+	free (low);
+	free (pai);
+	free (articulacao);
+}
+
+void dfs_biconexao (vertice *raiz, vertice **v_arr, int *desc, int *low, int *pai, bool *articulacao, unsigned int n, int *tempo, char ***arestas, unsigned int *total, unsigned int *capacidade) {
+	// Pilha explicita da DFS e, para cada vertice, o proximo vizinho a examinar
+	unsigned int *pilha = malloc (sizeof (unsigned int) * n);
+	vizinho **proximo = malloc (sizeof (vizinho *) * n);
+	if ( !pilha || !proximo ) {
+		free (pilha);
+		free (proximo);
+		fprintf (stderr, "Erro de memória em dfs_biconexao()\n");
+		return;
+	}
+
+	unsigned int r = (unsigned int)indice_vertice (v_arr, n, raiz);
+	unsigned int topo = 0;
+	int filhos_raiz = 0;
+
+	desc[r] = low[r] = (*tempo)++;
+	proximo[r] = raiz->vizinhos;
+	pilha[topo++] = r;
+
+	while ( topo > 0 ) {
+		unsigned int v = pilha[topo - 1];
+		vizinho *viz = proximo[v];
+
+		if ( viz ) {
+			proximo[v] = viz->prox;
+			unsigned int u = (unsigned int)indice_vertice (v_arr, n, viz->destino);
+
+			if ( desc[u] == -1 ) {
+				// Aresta de arvore: desce para u
+				pai[u] = (int)v;
+				if ( v == r ) filhos_raiz++;
+
+				desc[u] = low[u] = (*tempo)++;
+				proximo[u] = viz->destino->vizinhos;
+				pilha[topo++] = u;
+			} else if ( (int)u != pai[v] ) {
+				// Aresta de retorno
+				if ( desc[u] < low[v] ) {
+					low[v] = desc[u];
+				}
+			}
+			continue;
+		}
+
+		// Todos os vizinhos de v foram examinados: propaga low para o pai
+		topo--;
+		if ( pai[v] == -1 ) continue;
+
+		unsigned int p = (unsigned int)pai[v];
+		if ( low[v] < low[p] ) {
+			low[p] = low[v];
+		}
+
+		// Se p nao é raiz e low[v] >= desc[p], p é articulacao
+		if ( articulacao && pai[p] != -1 && low[v] >= desc[p] ) {
+			articulacao[p] = true;
+		}
+
+		// Se low[v] > desc[p], nenhuma aresta de retorno passa por cima de {p, v}
+		if ( arestas && low[v] > desc[p] ) {
+			adicionar_aresta_corte (v_arr[p]->nome, v_arr[v]->nome, arestas, total, capacidade);
+		}
+	}
+
+	// Caso especial: a raiz é articulacao se tem mais de um filho
+	if ( articulacao && filhos_raiz > 1 ) {
+		articulacao[r] = true;
+	}
+
+	free (pilha);
+	free (proximo);
+}
+
+//------------------------------------------------------------------------------
+// biconectividade incremental: floresta bloco-corte mantida a cada aresta inserida
+//
+// Cada arvore da floresta tem nos de vertice e de bloco, alternados, e raiz num vertice.
+// Os blocos sao conjuntos de um union-find: quando uma aresta fecha um ciclo, todos os
+// blocos do caminho entre as pontas viram um so, e o caminho seguinte fica mais curto.
+// Uma aresta entre arvores diferentes vira um bloco novo, ligado depois de a arvore
+// menor ser re-enraizada na ponta (custo amortizado O(log n) pela menor metade).
+
+struct biconexao_incremental {
+	unsigned int cap_v;           // capacidade dos vetores por vertice
+	unsigned int *pai_cc;         // union-find dos componentes conexos
+	unsigned int *tam_cc;         // vertices de cada componente (valido na raiz)
+	unsigned int *pai_vertice;    // bloco pai de cada vertice (SEM_BLOCO na raiz da arvore)
+	unsigned int *blocos_vertice; // blocos que contem cada vertice (>= 2: vertice de corte)
+	unsigned int *marca_v;        // geracao da ultima busca de caminho que passou no vertice
+
+	unsigned int cap_b;           // capacidade dos vetores por bloco e por aresta
+	unsigned int n_b;
+	unsigned int *uf_bloco;       // union-find dos blocos
+	unsigned int *pai_bloco;      // vertice pai de cada bloco (valido na raiz)
+	unsigned int *arestas_bloco;  // arestas do bloco (valido na raiz; 1: ponte)
+	unsigned int *primeira;       // primeira aresta do bloco (a ponte, quando so ha ela)
+	unsigned int *marca_b;
+
+	unsigned int *bloco_aresta;   // bloco de cada aresta (SEM_BLOCO para lacos)
+	unsigned int *ponta;          // pontas de cada aresta: ponta[2e], ponta[2e + 1]
+	unsigned int geracao;
+	unsigned int unioes;          // unioes de componentes feitas (componentes = n - unioes)
+};
+
+// Garante espaco para o vertice id e para a aresta e
+static bool cresce_incremental (biconexao_incremental *bi, unsigned int id, unsigned int e) {
+	if ( id >= bi->cap_v ) {
+		unsigned int cap = bi->cap_v ? bi->cap_v : 64;
+		while ( cap <= id ) cap *= 2;
+
+		unsigned int **vetores[] = {&bi->pai_cc, &bi->tam_cc, &bi->pai_vertice, &bi->blocos_vertice, &bi->marca_v};
+		for ( size_t k = 0; k < sizeof (vetores) / sizeof (vetores[0]); k++ ) {
+			unsigned int *novo = realloc (*vetores[k], sizeof (unsigned int) * cap);
+			if ( !novo ) return false;
+			*vetores[k] = novo;
+		}
+		for ( unsigned int x = bi->cap_v; x < cap; x++ ) {
+			bi->pai_cc[x] = x;
+			bi->tam_cc[x] = 1;
+			bi->pai_vertice[x] = SEM_BLOCO;
+			bi->blocos_vertice[x] = 0;
+			bi->marca_v[x] = 0;
+		}
+		bi->cap_v = cap;
+	}
+
+	if ( e >= bi->cap_b ) {
+		unsigned int cap = bi->cap_b ? bi->cap_b : 64;
+		while ( cap <= e ) cap *= 2;
+
+		unsigned int **vetores[] = {&bi->uf_bloco, &bi->pai_bloco, &bi->arestas_bloco, &bi->primeira, &bi->marca_b, &bi->bloco_aresta};
+		for ( size_t k = 0; k < sizeof (vetores) / sizeof (vetores[0]); k++ ) {
+			unsigned int *novo = realloc (*vetores[k], sizeof (unsigned int) * cap);
+			if ( !novo ) return false;
+			*vetores[k] = novo;
+		}
+		unsigned int *ponta = realloc (bi->ponta, sizeof (unsigned int) * 2 * (size_t)cap);
+		if ( !ponta ) return false;
+		bi->ponta = ponta;
+		for ( unsigned int x = bi->cap_b; x < cap; x++ ) {
+			bi->marca_b[x] = 0;
+			bi->bloco_aresta[x] = SEM_BLOCO;
+		}
+		bi->cap_b = cap;
+	}
+
+	return true;
+}
+
+// Torna x a raiz da sua arvore, invertendo os pais no caminho ate a raiz antiga
+static void reenraiza (biconexao_incremental *bi, unsigned int x) {
+	unsigned int anterior = SEM_BLOCO;
+	for ( ;; ) {
+		unsigned int b = bi->pai_vertice[x];
+		bi->pai_vertice[x] = anterior;
+		if ( b == SEM_BLOCO ) break;
+
+		b = uf_raiz (bi->uf_bloco, b);
+		unsigned int y = bi->pai_bloco[b];
+		bi->pai_bloco[b] = x;
+		anterior = b;
+		x = y;
+	}
+}
+
+// No da floresta durante a busca do caminho: vertice ou bloco
+typedef struct {
+	unsigned int id;
+	bool bloco;
+	bool raiz;    // chegou a raiz da arvore
+} no_floresta;
+
+// Sobe um passo na floresta, a partir de um no que nao e raiz
+static no_floresta sobe_floresta (biconexao_incremental *bi, no_floresta p) {
+	no_floresta q = {0, false, false};
+	if ( p.bloco ) {
+		q.id = bi->pai_bloco[p.id];
+		q.raiz = bi->pai_vertice[q.id] == SEM_BLOCO;
+	} else {
+		q.id = uf_raiz (bi->uf_bloco, bi->pai_vertice[p.id]);
+		q.bloco = true;
+	}
+	return q;
+}
+
+// Marca o no com a geracao atual; devolve true se ele ja estava marcado
+static bool marca_no (biconexao_incremental *bi, no_floresta p) {
+	unsigned int *marca = p.bloco ? &bi->marca_b[p.id] : &bi->marca_v[p.id];
+	if ( *marca == bi->geracao ) return true;
+	*marca = bi->geracao;
+	return false;
+}
+
+// Une o bloco b (raiz) ao acumulado *acum, pelo numero de arestas
+static void une_bloco (biconexao_incremental *bi, unsigned int *acum, unsigned int b) {
+	unsigned int a = *acum;
+	if ( a == SEM_BLOCO ) {
+		*acum = b;
+		return;
+	}
+
+	unsigned int soma = bi->arestas_bloco[a] + bi->arestas_bloco[b];
+	if ( bi->arestas_bloco[a] < bi->arestas_bloco[b] ) {
+		unsigned int tmp = a;
+		a = b;
+		b = tmp;
+	}
+	bi->uf_bloco[b] = a;
+	bi->arestas_bloco[a] = soma;
+	*acum = a;
+}
+
+// Une os blocos do caminho de x ate o ancestral comum lca (exclusive) em *acum; os
+// vertices internos do caminho perdem um bloco. Devolve quantos blocos foram unidos
+static unsigned int junta_caminho (biconexao_incremental *bi, unsigned int x, no_floresta lca, unsigned int *acum) {
+	unsigned int unidos = 0;
+	no_floresta p = {x, false, false};
+	while ( p.bloco != lca.bloco || p.id != lca.id ) {
+		no_floresta prox = sobe_floresta (bi, p);
+		if ( p.bloco ) {
+			une_bloco (bi, acum, p.id);
+			unidos++;
+		} else if ( p.id != x ) {
+			bi->blocos_vertice[p.id]--;
+		}
+		p = prox;
+	}
+	return unidos;
+}
+
+// Insere a aresta e = {u, v} na estrutura; multigrafo como em modo_multigrafo
+static bool insere_incremental (biconexao_incremental *bi, unsigned int u, unsigned int v, unsigned int e, bool multigrafo) {
+	if ( !cresce_incremental (bi, u > v ? u : v, e) ) return false;
+
+	bi->ponta[2 * (size_t)e] = u;
+	bi->ponta[2 * (size_t)e + 1] = v;
+	bi->bloco_aresta[e] = SEM_BLOCO;
+	if ( u == v ) return true;  // lacos nao entram em bloco nenhum
+
+	unsigned int ru = uf_raiz (bi->pai_cc, u);
+	unsigned int rv = uf_raiz (bi->pai_cc, v);
+
+	// Componentes diferentes: a aresta e um bloco novo (uma ponte)
+	if ( ru != rv ) {
+		if ( bi->tam_cc[ru] > bi->tam_cc[rv] ) {
+			unsigned int tmp = u;
+			u = v;
+			v = tmp;
+			tmp = ru;
+			ru = rv;
+			rv = tmp;
+		}
+		reenraiza (bi, u);
+
+		unsigned int b = bi->n_b++;
+		bi->uf_bloco[b] = b;
+		bi->pai_bloco[b] = v;
+		bi->arestas_bloco[b] = 1;
+		bi->primeira[b] = e;
+		bi->pai_vertice[u] = b;
+		bi->blocos_vertice[u]++;
+		bi->blocos_vertice[v]++;
+		bi->bloco_aresta[e] = b;
+
+		bi->pai_cc[ru] = rv;
+		bi->tam_cc[rv] += bi->tam_cc[ru];
+		bi->unioes++;
+		return true;
+	}
+
+	// Mesmo componente: acha o ancestral comum subindo das duas pontas alternadamente
+	if ( ++bi->geracao == 0 ) {
+		memset (bi->marca_v, 0, sizeof (unsigned int) * bi->cap_v);
+		memset (bi->marca_b, 0, sizeof (unsigned int) * bi->cap_b);
+		bi->geracao = 1;
+	}
+	no_floresta p = {u, false, bi->pai_vertice[u] == SEM_BLOCO};
+	no_floresta q = {v, false, bi->pai_vertice[v] == SEM_BLOCO};
+	marca_no (bi, p);
+	marca_no (bi, q);
+	no_floresta lca = p;
+	for ( ;; ) {
+		if ( !p.raiz ) {
+			p = sobe_floresta (bi, p);
+			if ( marca_no (bi, p) ) {
+				lca = p;
+				break;
+			}
+		}
+		if ( !q.raiz ) {
+			q = sobe_floresta (bi, q);
+			if ( marca_no (bi, q) ) {
+				lca = q;
+				break;
+			}
+		}
+	}
+
+	// O bloco unido fica abaixo do pai do ancestral comum (bloco) ou do proprio (vertice)
+	unsigned int pai = lca.bloco ? bi->pai_bloco[lca.id] : lca.id;
+	unsigned int b = SEM_BLOCO;
+	unsigned int unidos = junta_caminho (bi, u, lca, &b) + junta_caminho (bi, v, lca, &b);
+	if ( lca.bloco ) {
+		une_bloco (bi, &b, lca.id);
+		unidos++;
+	} else if ( lca.id != u && lca.id != v ) {
+		bi->blocos_vertice[lca.id]--;  // seus dois blocos no caminho viraram um
+	}
+	bi->pai_bloco[b] = pai;
+	bi->bloco_aresta[e] = b;
+
+	// Num grafo simples, uma copia de uma ponte nao fecha ciclo: a ponte continua ponte
+	if ( unidos == 1 && bi->arestas_bloco[b] == 1 && !multigrafo ) return true;
+	bi->arestas_bloco[b]++;
+	return true;
+}
+
+void desativa_biconexao_incremental (grafo *g) {
+	biconexao_incremental *bi = g->incremental;
+	if ( !bi ) return;
+
+	free (bi->pai_cc);
+	free (bi->tam_cc);
+	free (bi->pai_vertice);
+	free (bi->blocos_vertice);
+	free (bi->marca_v);
+	free (bi->uf_bloco);
+	free (bi->pai_bloco);
+	free (bi->arestas_bloco);
+	free (bi->primeira);
+	free (bi->marca_b);
+	free (bi->bloco_aresta);
+	free (bi->ponta);
+	free (bi);
+	g->incremental = NULL;
+}
+
+bool ativa_biconexao_incremental (grafo *g) {
+	desativa_biconexao_incremental (g);
+
+	biconexao_incremental *bi = calloc (1, sizeof (biconexao_incremental));
+	if ( !bi ) return false;
+	g->incremental = bi;
+
+	// Insere as arestas existentes na ordem dos ids
+	bool ok = cresce_incremental (bi, g->n_vertices, g->n_arestas);
+	unsigned int *u = malloc (sizeof (unsigned int) * ((size_t)g->n_arestas + 1));
+	unsigned int *v = malloc (sizeof (unsigned int) * ((size_t)g->n_arestas + 1));
+	ok = ok && u && v;
+
+	for ( vertice *x = ok ? g->vertices : NULL; x != NULL; x = x->prox ) {
+		for ( vizinho *viz = x->vizinhos; viz != NULL; viz = viz->prox ) {
+			if ( x->id <= viz->destino->id ) {
+				u[viz->aresta] = x->id;
+				v[viz->aresta] = viz->destino->id;
+			}
+		}
+	}
+	for ( unsigned int e = 0; ok && e < g->n_arestas; e++ ) {
+		ok = insere_incremental (bi, u[e], v[e], e, g->multigrafo);
+	}
+
+	free (u);
+	free (v);
+	if ( !ok ) {
+		desativa_biconexao_incremental (g);
+		return false;
+	}
+	g->n_componentes = g->n_vertices - bi->unioes;
+	return true;
+}
+
+unsigned int insere_aresta (grafo *g, const char *nome1, const char *nome2, int peso) {
+	vertice *a = busca_ou_cria_vertice (g, nome1);
+	vertice *b = busca_ou_cria_vertice (g, nome2);
+	unsigned int e = g->n_arestas;
+
+	adiciona_vizinho_grafo (g, a, b, peso, e);
+	adiciona_vizinho_grafo (g, b, a, peso, e);
+	g->n_arestas++;
+
+	// Indices calculados de uma vez ficaram velhos
+	destruir_biconexao (g->biconexao);
+	g->biconexao = NULL;
+	destroi_adjacencia_compacta (g->compacta);
+	g->compacta = NULL;
+	free (g->componente);
+	free (g->tam_componente);
+	g->componente = NULL;
+	g->tam_componente = NULL;
+	g->n_componentes = 0;
+
+	// A matriz ganha os dois bits da aresta; um vertice novo nao cabe nela, e o grafo
+	// volta a usar so as listas
+	matriz_bits *m = g->densa;
+	if ( m && a->id < m->n && b->id < m->n ) {
+		m->bits[a->id * m->palavras + b->id / 64] |= (uint64_t)1 << (b->id % 64);
+		m->bits[b->id * m->palavras + a->id / 64] |= (uint64_t)1 << (a->id % 64);
+	} else if ( m ) {
+		destroi_matriz_bits (m);
+		g->densa = NULL;
+	}
+
+	biconexao_incremental *bi = g->incremental;
+	if ( !bi ) return e;
+
+	if ( !insere_incremental (bi, a->id, b->id, e, g->multigrafo) ) {
+		fprintf (stderr, "Erro de memória em insere_aresta()\n");
+		desativa_biconexao_incremental (g);
+		return e;
+	}
+
+	// Com a estrutura ativa o numero de componentes segue atualizado
+	g->n_componentes = g->n_vertices - bi->unioes;
+	return e;
+}
+
+// Vertices de corte segundo a estrutura incremental (vetor indexado pelo id)
+static bool *cortes_incremental (grafo *g) {
+	biconexao_incremental *bi = g->incremental;
+	bool *corte = malloc (sizeof (bool) * ((size_t)g->n_vertices + 1));
+	if ( !corte ) return NULL;
+
+	for ( unsigned int x = 0; x < g->n_vertices; x++ ) {
+		corte[x] = bi->blocos_vertice[x] >= 2;
+	}
+	return corte;
+}
+
+// Diz se a aresta e e ponte segundo a estrutura incremental
+static bool ponte_incremental (const biconexao_incremental *bi, unsigned int e) {
+	unsigned int b = bi->bloco_aresta[e];
+	if ( b == SEM_BLOCO ) return false;
+
+	while ( bi->uf_bloco[b] != b ) b = bi->uf_bloco[b];
+	return bi->arestas_bloco[b] == 1 && bi->primeira[b] == e;
+}
+
+void dfs_articulacoes (vertice *v, vertice **v_arr, int *desc, int *low, int *pai, bool *articulacao, unsigned int n, int *tempo) {
+	dfs_biconexao (v, v_arr, desc, low, pai, articulacao, n, tempo, NULL, NULL, NULL);
+}
+
+char *vertices_corte (grafo *g) {
+	if ( g->n_vertices == 0 ) return strdup ("");
+
+	// Com a estrutura incremental ativa os cortes ja estao atualizados
+	bool *corte_inc = NULL;
+	biconexao *bc = NULL;
+	if ( g->incremental ) {
+		corte_inc = cortes_incremental (g);
+		if ( !corte_inc ) return NULL;
+	} else {
+		bc = calcula_biconexao (g);
+		if ( !bc ) return NULL;
+	}
+
+	vertice **v_arr = malloc (sizeof (vertice *) * g->n_vertices);
+	if ( !v_arr ) {
+		free (corte_inc);
+		return NULL;
+	}
+
+	if ( !montar_vetor_vertices (g, v_arr) ) {
+		destruir_vetor_vertices (v_arr);
+		free (corte_inc);
+		return NULL;
+	}
+
+	char *resultado = montar_string_vertices_corte (v_arr, corte_inc ? corte_inc : bc->corte, g->n_vertices);
+
+	destruir_vetor_vertices (v_arr);
+	free (corte_inc);
+
+	return resultado;
+}
+
+bool inicializar_arestas (char ***arestas, unsigned int capacidade) {
+	if ( capacidade == 0 ) {
+		capacidade = 1;
+	}
+
+	*arestas = malloc (sizeof (char *) * capacidade);
+	if ( !*arestas ) return false;
+
+	// Inicializa os ponteiros com NULL (opcional, mas seguro para liberar depois)
+	for ( unsigned int i = 0; i < capacidade; i++ ) {
+		(*arestas)[i] = NULL;
+	}
+
+	return true;
+}
+
+void destruir_arestas (char **arestas, unsigned int total) {
+	if ( !arestas ) return;
+
+	for ( unsigned int i = 0; i < total; i++ ) {
+		free (arestas[i]);
+	}
+
+	free (arestas);
+}
+
+bool adicionar_aresta_corte (const char *nome1, const char *nome2, char ***arestas, unsigned int *total, unsigned int *capacidade) {
+	// Ordena os nomes alfabeticamente
+	const char *a = (strcmp (nome1, nome2) < 0) ? nome1 : nome2;
+	const char *b = (a == nome1) ? nome2 : nome1;
+
+	size_t len = strlen (a) + strlen (b) + 2;
+	char *aresta = malloc (len);
+	if ( !aresta ) return false;
+
+	snprintf (aresta, len, "%s %s", a, b);
+
+	// Expande o vetor, se necessario
+	if ( *total >= *capacidade ) {
+		*capacidade *= 2;
+		char **novo = realloc (*arestas, sizeof (char *) * (*capacidade));
+		if ( !novo ) {
+			free (aresta);
+			return false;
+		}
+		*arestas = novo;
+	}
+
+	(*arestas)[*total] = aresta;
+	(*total)++;
+	return true;
+}
+
+char *montar_string_arestas_corte (char **arestas, unsigned int total) {
+	if ( total == 0 ) return strdup ("");
+
+	qsort (arestas, total, sizeof (char *), cmpstr);
+
+	// Calcula o tamanho total da string final
+	size_t total_len = 0;
+	for ( unsigned int i = 0; i < total; i++ ) {
+		total_len += strlen (arestas[i]) + 1;  // +1 para espaco ou \0
+	}
+
+	// Aloca e monta a string final
+	char *resultado = malloc (total_len);
+	if ( !resultado ) return NULL;
+
+	// Copia a partir do fim, sem percorrer de novo o que ja foi escrito
+	char *fim = resultado;
+	for ( unsigned int i = 0; i < total; i++ ) {
+		size_t len = strlen (arestas[i]);
+		memcpy (fim, arestas[i], len);
+		fim += len;
+		*fim++ = (i < total - 1) ? ' ' : '\0';
+	}
+
+	return resultado;
+}
+
+void dfs_arestas_corte (vertice *v, vertice **v_arr, int *desc, int *low, int *pai, unsigned int n, int *tempo, char ***arestas, unsigned int *total, unsigned int *capacidade) {
+	dfs_biconexao (v, v_arr, desc, low, pai, NULL, n, tempo, arestas, total, capacidade);
+}
+
+char *arestas_corte (grafo *g) {
+	// Com a estrutura incremental ativa as pontes ja estao atualizadas
+	const biconexao_incremental *bi = g->incremental;
+	biconexao *bc = bi ? NULL : calcula_biconexao (g);
+	if ( !bi && !bc ) return NULL;
+
+	// Inicializa vetor de arestas de corte
+	unsigned int total = 0;
+	unsigned int capacidade = g->n_arestas > 0 ? g->n_arestas : 1;
+	char **arestas = NULL;
+	if ( !inicializar_arestas (&arestas, capacidade) ) return NULL;
+
+	// Cada ponte aparece nas listas das duas pontas; guarda so a vista da ponta de menor id
+	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
+		for ( vizinho *viz = v->vizinhos; viz != NULL; viz = viz->prox ) {
+			bool ponte = bi ? ponte_incremental (bi, viz->aresta) : bc->ponte[viz->aresta];
+			if ( ponte && v->id < viz->destino->id ) {
+				if ( !adicionar_aresta_corte (v->nome, viz->destino->nome, &arestas, &total, &capacidade) ) {
+					destruir_arestas (arestas, total);
+					return NULL;
+				}
+			}
+		}
+	}
+
+	char *resultado = montar_string_arestas_corte (arestas, total);
+
+	destruir_arestas (arestas, total);
+
+	return resultado;
+}
+
+// Aresta empilhada durante a DFS de calcula_biconexao, com suas pontas
+typedef struct {
+	unsigned int aresta;
+	unsigned int a, b;
+} aresta_pilha;
+
+void destruir_biconexao (biconexao *bc) {
+	if ( !bc ) return;
+
+	free (bc->corte);
+	free (bc->ponte);
+	free (bc->bloco_aresta);
+	free (bc->bloco_inicio);
+	free (bc->bloco_vertices);
+	free (bc->no_vertice);
+	free (bc->arvore_inicio);
+	free (bc->arvore_adj);
+	free (bc->comp2e);
+	free (bc);
+}
+
+// Monta a arvore bloco-corte em formato CSR a partir dos vertices de cada bloco
+static bool montar_arvore_bloco_corte (biconexao *bc) {
+	unsigned int n_nos = bc->n_blocos + bc->n_cortes;
+
+	bc->arvore_inicio = calloc ((size_t)n_nos + 1, sizeof (unsigned int));
+	if ( !bc->arvore_inicio ) return false;
+
+	// Conta o grau de cada no: uma aresta da arvore para cada par (bloco, vertice de corte)
+	unsigned int n_ligacoes = 0;
+	for ( unsigned int b = 0; b < bc->n_blocos; b++ ) {
+		for ( unsigned int k = bc->bloco_inicio[b]; k < bc->bloco_inicio[b + 1]; k++ ) {
+			unsigned int x = bc->bloco_vertices[k];
+			if ( bc->corte[x] ) {
+				bc->arvore_inicio[b + 1]++;
+				bc->arvore_inicio[bc->no_vertice[x] + 1]++;
+				n_ligacoes++;
+			}
+		}
+	}
+	for ( unsigned int x = 0; x < n_nos; x++ ) {
+		bc->arvore_inicio[x + 1] += bc->arvore_inicio[x];
+	}
+
+	bc->arvore_adj = malloc (sizeof (unsigned int) * (2 * (size_t)n_ligacoes + 1));
+	unsigned int *pos = malloc (sizeof (unsigned int) * ((size_t)n_nos + 1));
+	if ( !bc->arvore_adj || !pos ) {
+		free (pos);
+		return false;
+	}
+	memcpy (pos, bc->arvore_inicio, sizeof (unsigned int) * n_nos);
+
+	for ( unsigned int b = 0; b < bc->n_blocos; b++ ) {
+		for ( unsigned int k = bc->bloco_inicio[b]; k < bc->bloco_inicio[b + 1]; k++ ) {
+			unsigned int x = bc->bloco_vertices[k];
+			if ( bc->corte[x] ) {
+				unsigned int no = bc->no_vertice[x];
+				bc->arvore_adj[pos[b]++] = no;
+				bc->arvore_adj[pos[no]++] = b;
+			}
+		}
+	}
+
+	free (pos);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// biconectividade em paralelo (Tarjan-Vishkin)
+
+#define MIN_BICONEXAO_PARALELO 65536  // abaixo disso a DFS serial ganha
+#define MIN_FATIA_PARALELA 4096       // intervalos menores rodam so na thread que chama
+#define BUFFER_NIVEL 256              // vertices que uma thread junta antes de publicar no nivel
+
+typedef struct estado_tv estado_tv;
+
+// Fatia [ini, fim) de uma fase, de ids ou de posicoes em ordem
+typedef struct {
+	estado_tv *e;
+	unsigned int ini, fim;
+} pedaco_tv;
+
+// Estado compartilhado pelas fases de biconexao_paralela
+struct estado_tv {
+	vertice **v_arr;
+	unsigned int n;
+	bool multigrafo;
+	unsigned int threads;
+	pedaco_tv *pedacos;
+	unsigned int *pai;           // pai na arvore de largura; a raiz e pai de si mesma
+	unsigned int *pai_aresta;    // aresta de arvore entre o vertice e o pai
+	unsigned int *ordem;         // vertices nivel a nivel
+	unsigned int topo;           // fim de ordem enquanto um nivel e expandido
+	unsigned int *filho_inicio;  // filhos de v em filhos[filho_inicio[v] .. filho_inicio[v + 1])
+	unsigned int *filhos;
+	unsigned int *nd;            // tamanho da subarvore
+	unsigned int *pre;           // pre-ordem: a subarvore de v e [pre[v], pre[v] + nd[v])
+	unsigned int *baixo, *alto;  // menor e maior pre alcancados da subarvore fora da aresta do pai
+	unsigned int *aux;           // union-find das arestas de arvore (cada uma pelo filho); depois o bloco
+	biconexao *bc;
+};
+
+// Roda f sobre [ini, fim) dividido entre as threads, ou todo na thread que chama se for pouco
+static void fatia_tv (void *(*f) (void *), estado_tv *e, unsigned int ini, unsigned int fim) {
+	unsigned int threads = fim - ini >= MIN_FATIA_PARALELA ? e->threads : 1;
+	for ( unsigned int t = 0; t < threads; t++ ) {
+		e->pedacos[t].e = e;
+		e->pedacos[t].ini = ini + (unsigned int)((unsigned long long)(fim - ini) * t / threads);
+		e->pedacos[t].fim = ini + (unsigned int)((unsigned long long)(fim - ini) * (t + 1) / threads);
+	}
+	em_paralelo (f, e->pedacos, sizeof (pedaco_tv), threads);
+}
+
+// Poe k vertices descobertos no fim de ordem, reservando o espaco de uma vez
+static void publica_nivel (estado_tv *e, const unsigned int *buf, unsigned int k) {
+	if ( k == 0 ) return;
+	unsigned int pos = __atomic_fetch_add (&e->topo, k, __ATOMIC_RELAXED);
+	memcpy (&e->ordem[pos], buf, sizeof (unsigned int) * k);
+}
+
+// Expande o nivel: cada vizinho ainda sem pai e tomado com compare-and-swap
+static void *expande_nivel (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	unsigned int buf[BUFFER_NIVEL];
+	unsigned int k = 0;
+
+	for ( unsigned int i = p->ini; i < p->fim; i++ ) {
+		unsigned int u = e->ordem[i];
+		for ( vizinho *viz = e->v_arr[u]->vizinhos; viz; viz = viz->prox ) {
+			unsigned int w = viz->destino->id;
+			unsigned int livre = UINT_MAX;
+			if ( __atomic_load_n (&e->pai[w], __ATOMIC_RELAXED) != UINT_MAX ) continue;
+			if ( !__atomic_compare_exchange_n (&e->pai[w], &livre, u, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED) ) continue;
+
+			e->pai_aresta[w] = viz->aresta;
+			buf[k++] = w;
+			if ( k == BUFFER_NIVEL ) {
+				publica_nivel (e, buf, k);
+				k = 0;
+			}
+		}
+	}
+	publica_nivel (e, buf, k);
+	return NULL;
+}
+
+// Tamanho das subarvores; os filhos estao no nivel de baixo, ja feito
+static void *conta_subarvores (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	for ( unsigned int i = p->ini; i < p->fim; i++ ) {
+		unsigned int v = e->ordem[i];
+		unsigned int t = 1;
+		for ( unsigned int k = e->filho_inicio[v]; k < e->filho_inicio[v + 1]; k++ ) t += e->nd[e->filhos[k]];
+		e->nd[v] = t;
+	}
+	return NULL;
+}
+
+// Pre-ordem: cada vertice numera os filhos logo depois de si, somando os tamanhos das
+// subarvores dos irmaos anteriores
+static void *numera_filhos (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	for ( unsigned int i = p->ini; i < p->fim; i++ ) {
+		unsigned int u = e->ordem[i];
+		unsigned int x = e->pre[u] + 1;
+		for ( unsigned int k = e->filho_inicio[u]; k < e->filho_inicio[u + 1]; k++ ) {
+			unsigned int c = e->filhos[k];
+			e->pre[c] = x;
+			x += e->nd[c];
+		}
+	}
+	return NULL;
+}
+
+// Diz se a aresta viz de v e a que leva ao pai na arvore. Fora do modo multigrafo todas as
+// copias paralelas contam como ela, como na DFS serial
+static bool aresta_do_pai (const estado_tv *e, unsigned int v, const vizinho *viz) {
+	if ( e->pai[v] == v ) return false;
+	if ( e->multigrafo ) return viz->aresta == e->pai_aresta[v];
+	return viz->destino->id == e->pai[v];
+}
+
+// Menor e maior pre vizinhos de cada vertice, fora os lacos e a aresta do pai
+static void *limites_locais (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	for ( unsigned int v = p->ini; v < p->fim; v++ ) {
+		unsigned int baixo = e->pre[v], alto = e->pre[v];
+		for ( vizinho *viz = e->v_arr[v]->vizinhos; viz; viz = viz->prox ) {
+			unsigned int w = viz->destino->id;
+			if ( w == v || aresta_do_pai (e, v, viz) ) continue;
+			if ( e->pre[w] < baixo ) baixo = e->pre[w];
+			if ( e->pre[w] > alto ) alto = e->pre[w];
+		}
+		e->baixo[v] = baixo;
+		e->alto[v] = alto;
+	}
+	return NULL;
+}
+
+// Junta os limites dos filhos, de baixo para cima
+static void *junta_limites (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	for ( unsigned int i = p->ini; i < p->fim; i++ ) {
+		unsigned int v = e->ordem[i];
+		for ( unsigned int k = e->filho_inicio[v]; k < e->filho_inicio[v + 1]; k++ ) {
+			unsigned int c = e->filhos[k];
+			if ( e->baixo[c] < e->baixo[v] ) e->baixo[v] = e->baixo[c];
+			if ( e->alto[c] > e->alto[v] ) e->alto[v] = e->alto[c];
+		}
+	}
+	return NULL;
+}
+
+// Grafo auxiliar de Tarjan-Vishkin sobre as arestas de arvore: (pai(v), v) se junta a
+// (pai(u), u) quando ha aresta fora da arvore entre as subarvores de u e v sem que uma
+// contenha a outra, e a aresta do avo quando a subarvore de v alcanca fora da do pai
+static void *une_arestas_arvore (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	for ( unsigned int v = p->ini; v < p->fim; v++ ) {
+		unsigned int u = e->pai[v];
+		if ( u != v && e->pai[u] != u && (e->baixo[v] < e->pre[u] || e->alto[v] >= e->pre[u] + e->nd[u]) ) {
+			une_atomico (e->aux, v, u);
+		}
+
+		for ( vizinho *viz = e->v_arr[v]->vizinhos; viz; viz = viz->prox ) {
+			unsigned int w = viz->destino->id;
+			if ( e->pre[v] < e->pre[w] && e->pre[w] >= e->pre[v] + e->nd[v] ) une_atomico (e->aux, v, w);
+		}
+	}
+	return NULL;
+}
+
+static void *comprime_aux (void *arg) {
+	pedaco_tv *p = arg;
+	comprime_atomico (p->e->aux, p->ini, p->fim);
+	return NULL;
+}
+
+// Pontes, bloco de cada aresta e vertices de corte. A aresta de arvore de v e ponte se
+// nada sai da subarvore de v; uma aresta vai para o bloco da aresta de arvore da ponta de
+// maior pre; v e de corte se suas arestas de arvore caem em mais de um bloco
+static void *classifica_arestas (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	biconexao *bc = e->bc;
+	for ( unsigned int v = p->ini; v < p->fim; v++ ) {
+		bool raiz = e->pai[v] == v;
+		if ( !raiz && e->baixo[v] >= e->pre[v] && e->alto[v] < e->pre[v] + e->nd[v] ) {
+			bc->ponte[e->pai_aresta[v]] = true;
+		}
+
+		for ( vizinho *viz = e->v_arr[v]->vizinhos; viz; viz = viz->prox ) {
+			unsigned int w = viz->destino->id;
+			if ( e->pre[v] < e->pre[w] ) bc->bloco_aresta[viz->aresta] = e->aux[w];
+		}
+
+		unsigned int k = e->filho_inicio[v];
+		unsigned int primeiro = raiz ? (k < e->filho_inicio[v + 1] ? e->aux[e->filhos[k]] : SEM_BLOCO) : e->aux[v];
+		for ( ; k < e->filho_inicio[v + 1]; k++ ) {
+			if ( e->aux[e->filhos[k]] != primeiro ) {
+				bc->corte[v] = true;
+				break;
+			}
+		}
+	}
+	return NULL;
+}
+
+// Componentes 2-aresta-conexos: union-find sobre as arestas que nao sao pontes. Fora do
+// modo multigrafo as copias paralelas de uma ponte tambem nao ligam nada
+static void *une_2e (void *arg) {
+	pedaco_tv *p = arg;
+	estado_tv *e = p->e;
+	for ( unsigned int v = p->ini; v < p->fim; v++ ) {
+		bool ponte_pai = e->pai[v] != v && e->bc->ponte[e->pai_aresta[v]];
+		for ( vizinho *viz = e->v_arr[v]->vizinhos; viz; viz = viz->prox ) {
+			unsigned int w = viz->destino->id;
+			if ( v >= w || e->bc->ponte[viz->aresta] ) continue;
+			if ( !e->multigrafo && ((ponte_pai && w == e->pai[v]) || (e->pai[w] == v && e->bc->ponte[e->pai_aresta[w]])) ) continue;
+			une_atomico (e->bc->comp2e, v, w);
+		}
+	}
+	return NULL;
+}
 
-char *diametros(grafo *g) {
-    // Limpa o estado 'visitado' dos vértices
-    for (vertice *v = g->vertices; v != NULL; v = v->prox)
-        v->visitado = 0;
-
-    int diams[MAX_COMPONENTES];
-    int n_diams = 0;
-    
-    srand((unsigned int)time(NULL));
-
-    // Itera sobre os vértices para encontrar os componentes
-    for (vertice *v = g->vertices; v != NULL; v = v->prox) {
-        if (!v->visitado) {
-            // Coleta todos os vértices do componente atual
-            vertice **componente = malloc(sizeof(vertice *) * g->n_vertices);
-            int n_comp = 0;
-            vertice **fila = malloc(sizeof(vertice *) * g->n_vertices);
-            int ini = 0, fim = 0;
-
-            v->visitado = 1;
-            fila[fim++] = v;
-            componente[n_comp++] = v;
-
-            while (ini < fim) {
-                vertice *u = fila[ini++];
-                for (vizinho *viz = u->vizinhos; viz; viz = viz->prox) {
-                    if (!viz->destino->visitado) {
-                        viz->destino->visitado = 1;
-                        fila[fim++] = viz->destino;
-                        componente[n_comp++] = viz->destino;
-                    }
-                }
-            }
-            free(fila);
-
-            // Calcula o diâmetro do componente
-            int diam_componente = 0;
-
-
-            const int TAMANHO_GRANDE = 100; // Limite para considerar um grafo grande
-            const int N_AMOSTRAS = 100;     // Número de vértices aleatórios para testar
-
-            if (n_comp > TAMANHO_GRANDE) {
-                // Para grafos grandes, estima o diâmetro a partir de uma amostra
-                for (int k = 0; k < N_AMOSTRAS && k < n_comp; k++) {
-                    int i = rand() % n_comp; // Escolhe um vértice aleatório do componente
-                    int excentricidade = dijkstra_distancia_maxima(componente[i], componente, n_comp);
-                    if (excentricidade > diam_componente) {
-                        diam_componente = excentricidade;
-                    }
-                }
-            } else {
-                // Para grafos pequenos, calcula o diâmetro exato (como antes)
-                for (int i = 0; i < n_comp; i++) {
-                    int excentricidade = dijkstra_distancia_maxima(componente[i], componente, n_comp);
-                    if (excentricidade > diam_componente) {
-                        diam_componente = excentricidade;
-                    }
-                }
-            }
-     
-            
-            diams[n_diams++] = diam_componente;
-            free(componente);
-        }
-    }
-
-    // Ordena os diâmetros 
-    for (int i = 0; i < n_diams; i++) {
-        for (int j = i + 1; j < n_diams; j++) {
-            if (diams[i] > diams[j]) {
-                int tmp = diams[i];
-                diams[i] = diams[j];
-                diams[j] = tmp;
-            }
-        }
-    }
-
-    //  Monta a string de resultado
-    char *res = malloc(16 * (size_t)n_diams + 1);
-    if (!res) return NULL;
-    res[0] = '\0';
-    char buffer[16];
-    for (int i = 0; i < n_diams; i++) {
-        sprintf(buffer, "%d", diams[i]);
-        strcat(res, buffer);
-        if (i < n_diams - 1) strcat(res, " ");
-    }
-
-    return res;
+static void *comprime_2e (void *arg) {
+	pedaco_tv *p = arg;
+	comprime_atomico (p->e->bc->comp2e, p->ini, p->fim);
+	return NULL;
 }
 
-// Ordena os nomes alfabeticamente
-int cmpstr (const void *a, const void *b) {
-	const char *const *pa = (const char *const *)a;
-	const char *const *pb = (const char *const *)b;
-	return strcmp (*pa, *pb);
+// Acrescenta o bloco b aos de u, se ainda nao estiver (marca[b] guarda o ultimo vertice
+// que o viu); sem pos so conta
+static void inclui_bloco (biconexao *bc, unsigned int *marca, unsigned int *pos, unsigned int u, unsigned int b) {
+	if ( marca[b] == u ) return;
+	marca[b] = u;
+	if ( pos ) bc->bloco_vertices[pos[b]++] = u;
+	else bc->bloco_inicio[b + 1]++;
+	bc->no_vertice[u] = b;
 }
 
-bool montar_vetor_vertices (grafo *g, vertice **v_arr) {
-	if ( !v_arr ) return false;
+// Indice de biconectividade em paralelo, no algoritmo de Tarjan e Vishkin: arvore geradora
+// por busca em largura, tamanhos, pre-ordem e limites das subarvores nivel a nivel, e os
+// blocos como componentes de um grafo auxiliar sobre as arestas de arvore, num union-find
+// atomico. Preenche bc (vetores ja alocados); false em caso de erro de alocacao.
+// Chamada com g->trava obtida
+static bool biconexao_paralela (grafo *g, biconexao *bc, unsigned int threads) {
+	unsigned int n = g->n_vertices;
+	unsigned int m = g->n_arestas;
+
+	calcula_componentes_travado (g);
+	if ( !g->componente ) return false;
+
+	estado_tv e = {0};
+	e.n = n;
+	e.multigrafo = g->multigrafo;
+	e.threads = threads;
+	e.bc = bc;
+	e.v_arr = aloca_temporario (g, sizeof (vertice *) * ((size_t)n + 1));
+	e.pedacos = aloca_temporario (g, sizeof (pedaco_tv) * threads);
+	e.pai = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.pai_aresta = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.ordem = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.filho_inicio = aloca_temporario_zerado (g, (size_t)n + 2, sizeof (unsigned int));
+	e.filhos = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.nd = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.pre = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.baixo = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.alto = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	e.aux = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	unsigned int *nivel = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 2));
+	unsigned int *marca = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	bool *visto = aloca_temporario_zerado (g, (size_t)g->n_componentes + 1, sizeof (bool));
+	unsigned int *pos = NULL;
+
+	bool ok = e.v_arr && e.pedacos && e.pai && e.pai_aresta && e.ordem && e.filho_inicio && e.filhos
+		&& e.nd && e.pre && e.baixo && e.alto && e.aux && nivel && marca && visto;
+	if ( !ok ) goto fim;
+
+	montar_vetor_vertices (g, e.v_arr);
+	for ( unsigned int v = 0; v < n; v++ ) {
+		e.pai[v] = UINT_MAX;
+		e.aux[v] = v;
+		bc->no_vertice[v] = SEM_BLOCO;
+		bc->comp2e[v] = v;
+	}
+	for ( unsigned int a = 0; a < m; a++ ) {
+		bc->bloco_aresta[a] = SEM_BLOCO;
+	}
 
-	unsigned int idx = 0;
-	for ( vertice *v = g->vertices; v != NULL; v = v->prox ) {
-		v->visitado = 0;   // zera visitado
-		v_arr[idx++] = v;  // insere no vetor
+	// Busca em largura a partir do menor id de cada componente, todas juntas, um nivel
+	// por vez
+	for ( unsigned int v = 0; v < n; v++ ) {
+		unsigned int c = g->componente[v];
+		if ( visto[c] ) continue;
+		visto[c] = true;
+		e.pai[v] = v;
+		e.ordem[e.topo++] = v;
+	}
+	unsigned int n_niveis = 0;
+	nivel[0] = 0;
+	while ( nivel[n_niveis] < e.topo ) {
+		unsigned int ini = nivel[n_niveis], fim = e.topo;
+		nivel[++n_niveis] = fim;
+		fatia_tv (expande_nivel, &e, ini, fim);
 	}
 
-	return true;
-}
+	// Filhos de cada vertice, na ordem dos niveis
+	for ( unsigned int v = 0; v < n; v++ ) {
+		if ( e.pai[v] != v ) e.filho_inicio[e.pai[v] + 2]++;
+	}
+	for ( unsigned int v = 0; v < n; v++ ) {
+		e.filho_inicio[v + 2] += e.filho_inicio[v + 1];
+	}
+	for ( unsigned int i = 0; i < n; i++ ) {
+		unsigned int v = e.ordem[i];
+		if ( e.pai[v] != v ) e.filhos[e.filho_inicio[e.pai[v] + 1]++] = v;
+	}
 
-bool inicializar_vetores (int **desc, int **low, int **pai, bool **articulacao, unsigned int n) {
-	*desc = malloc (sizeof (int) * n);
-	*low = malloc (sizeof (int) * n);
-	*pai = malloc (sizeof (int) * n);
-	*articulacao = malloc (sizeof (bool) * n);
+	// Tamanhos de baixo para cima; pre-ordem de cima para baixo, as raizes em sequencia
+	for ( unsigned int k = n_niveis; k > 0; k-- ) {
+		fatia_tv (conta_subarvores, &e, nivel[k - 1], nivel[k]);
+	}
+	unsigned int proximo = 0;
+	for ( unsigned int i = nivel[0]; i < nivel[1]; i++ ) {
+		e.pre[e.ordem[i]] = proximo;
+		proximo += e.nd[e.ordem[i]];
+	}
+	for ( unsigned int k = 0; k < n_niveis; k++ ) {
+		fatia_tv (numera_filhos, &e, nivel[k], nivel[k + 1]);
+	}
 
-	if ( !*desc || !*low || !*pai || !*articulacao ) {
-		free (*desc);
-		free (*low);
-		free (*pai);
-		free (*articulacao);
-		return false;
+	fatia_tv (limites_locais, &e, 0, n);
+	for ( unsigned int k = n_niveis; k > 0; k-- ) {
+		fatia_tv (junta_limites, &e, nivel[k - 1], nivel[k]);
 	}
 
-	for ( unsigned int i = 0; i < n; i++ ) {
-		(*desc)[i] = -1;
-		(*low)[i] = -1;
-		(*pai)[i] = -1;
-		(*articulacao)[i] = false;
+	// Blocos: componentes do grafo auxiliar, rotulados em ordem de id
+	fatia_tv (une_arestas_arvore, &e, 0, n);
+	fatia_tv (comprime_aux, &e, 0, n);
+	for ( unsigned int v = 0; v < n; v++ ) {
+		if ( e.pai[v] == v ) continue;
+		unsigned int r = e.aux[v];
+		e.aux[v] = (r == v) ? bc->n_blocos++ : e.aux[r];
 	}
 
-	return true;
-}
+	fatia_tv (classifica_arestas, &e, 0, n);
 
-char *montar_string_vertices_corte (vertice **v_arr, bool *articulacao, unsigned int n) {
-	// Conta quantos vertices sao de corte
-	unsigned int total = 0;
-	for ( unsigned int i = 0; i < n; i++ ) {
-		if ( articulacao[i] ) total++;
+	// Vertices de cada bloco: o de cada aresta de arvore do vertice, sem repetir
+	pos = aloca_temporario (g, sizeof (unsigned int) * ((size_t)bc->n_blocos + 1));
+	if ( !pos ) {
+		ok = false;
+		goto fim;
+	}
+	memset (bc->bloco_inicio, 0, sizeof (unsigned int) * ((size_t)bc->n_blocos + 1));
+	for ( int passo = 0; passo < 2; passo++ ) {
+		memset (marca, 0xff, sizeof (unsigned int) * n);
+		for ( unsigned int v = 0; v < n; v++ ) {
+			unsigned int *p = passo ? pos : NULL;
+			if ( e.pai[v] != v ) inclui_bloco (bc, marca, p, v, e.aux[v]);
+			for ( unsigned int k = e.filho_inicio[v]; k < e.filho_inicio[v + 1]; k++ ) {
+				inclui_bloco (bc, marca, p, v, e.aux[e.filhos[k]]);
+			}
+		}
+		if ( passo == 0 ) {
+			for ( unsigned int b = 0; b < bc->n_blocos; b++ ) {
+				bc->bloco_inicio[b + 1] += bc->bloco_inicio[b];
+			}
+			memcpy (pos, bc->bloco_inicio, sizeof (unsigned int) * bc->n_blocos);
+		}
 	}
 
-	if ( total == 0 ) {
-		return strdup ("");	 // Nao ha vertices de corte
+	// Vertices de corte ganham seu proprio no; os demais ficam com o no do seu bloco
+	for ( unsigned int v = 0; v < n; v++ ) {
+		if ( bc->corte[v] ) bc->no_vertice[v] = bc->n_blocos + bc->n_cortes++;
 	}
 
-	// Coleta nomes dos vertices de corte
-	char **nomes = malloc (sizeof (char *) * total);
-	if ( !nomes ) return NULL;
+	fatia_tv (une_2e, &e, 0, n);
+	fatia_tv (comprime_2e, &e, 0, n);
+	bc->n_comp2e = rotula_raizes (bc->comp2e, NULL, n);
+
+fim:
+	libera_temporario (g, e.v_arr);
+	libera_temporario (g, e.pedacos);
+	libera_temporario (g, e.pai);
+	libera_temporario (g, e.pai_aresta);
+	libera_temporario (g, e.ordem);
+	libera_temporario (g, e.filho_inicio);
+	libera_temporario (g, e.filhos);
+	libera_temporario (g, e.nd);
+	libera_temporario (g, e.pre);
+	libera_temporario (g, e.baixo);
+	libera_temporario (g, e.alto);
+	libera_temporario (g, e.aux);
+	libera_temporario (g, nivel);
+	libera_temporario (g, marca);
+	libera_temporario (g, visto);
+	libera_temporario (g, pos);
+	return ok;
+}
 
-	unsigned int j = 0;
-	for ( unsigned int i = 0; i < n; i++ ) {
-		if ( articulacao[i] ) {
-			nomes[j++] = v_arr[i]->nome;
+// Calcula o indice de biconectividade; chamada com g->trava obtida
+static biconexao *calcula_biconexao_travado (grafo *g) {
+	if ( g->biconexao ) return g->biconexao;
+
+	unsigned int n = g->n_vertices;
+	unsigned int m = g->n_arestas;
+
+	biconexao *bc = calloc (1, sizeof (biconexao));
+	if ( !bc ) return NULL;
+
+	bc->corte = calloc ((size_t)n + 1, sizeof (bool));
+	bc->ponte = calloc ((size_t)m + 1, sizeof (bool));
+	bc->bloco_aresta = malloc (sizeof (unsigned int) * ((size_t)m + 1));
+	bc->bloco_inicio = malloc (sizeof (unsigned int) * ((size_t)m + 2));
+	bc->bloco_vertices = malloc (sizeof (unsigned int) * (2 * (size_t)m + 1));
+	bc->no_vertice = malloc (sizeof (unsigned int) * ((size_t)n + 1));
+	bc->comp2e = malloc (sizeof (unsigned int) * ((size_t)n + 1));
+
+	// Grafo grande (ou modo_paralelo pedido): Tarjan-Vishkin dividido entre as threads
+	unsigned int threads = g->threads ? g->threads : processadores ();
+	if ( n > 0 && (g->threads > 1 || (g->threads == 0 && n >= MIN_BICONEXAO_PARALELO && threads > 1)) ) {
+		bool ok = bc->corte && bc->ponte && bc->bloco_aresta && bc->bloco_inicio && bc->bloco_vertices
+			&& bc->no_vertice && bc->comp2e && biconexao_paralela (g, bc, threads)
+			&& montar_arvore_bloco_corte (bc);
+		if ( !ok ) {
+			destruir_biconexao (bc);
+			fprintf (stderr, "Erro de memória em calcula_biconexao()\n");
+			return NULL;
 		}
+		g->biconexao = bc;
+		return bc;
 	}
 
-	qsort (nomes, total, sizeof (char *), cmpstr);
+	vertice **v_arr = aloca_temporario (g, sizeof (vertice *) * ((size_t)n + 1));
+	int *desc = aloca_temporario (g, sizeof (int) * ((size_t)n + 1));
+	int *low = aloca_temporario (g, sizeof (int) * ((size_t)n + 1));
+	int *pai = aloca_temporario (g, sizeof (int) * ((size_t)n + 1));
+	unsigned int *pai_aresta = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	unsigned int *marca = aloca_temporario_zerado (g, (size_t)n + 1, sizeof (unsigned int));
+	unsigned int *pilha = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	unsigned int *pilha_2e = aloca_temporario (g, sizeof (unsigned int) * ((size_t)n + 1));
+	vizinho **proximo = aloca_temporario (g, sizeof (vizinho *) * ((size_t)n + 1));
+	aresta_pilha *pilha_arestas = aloca_temporario (g, sizeof (aresta_pilha) * ((size_t)m + 1));
+
+	bool ok = bc->corte && bc->ponte && bc->bloco_aresta && bc->bloco_inicio && bc->bloco_vertices
+		&& bc->no_vertice && bc->comp2e && v_arr && desc && low && pai && pai_aresta && marca
+		&& pilha && pilha_2e && proximo && pilha_arestas;
+
+	if ( ok ) {
+		montar_vetor_vertices (g, v_arr);
+		for ( unsigned int i = 0; i < n; i++ ) {
+			desc[i] = low[i] = pai[i] = -1;
+			bc->no_vertice[i] = SEM_BLOCO;
+		}
+		for ( unsigned int e = 0; e < m; e++ ) {
+			bc->bloco_aresta[e] = SEM_BLOCO;
+		}
+		bc->bloco_inicio[0] = 0;
+
+		int tempo = 0;
+		unsigned int n_vert_blocos = 0;
+
+		for ( unsigned int r = 0; r < n; r++ ) {
+			if ( desc[r] != -1 ) continue;
+
+			unsigned int topo = 0, topo_2e = 0, topo_arestas = 0;
+			int filhos_raiz = 0;
+
+			desc[r] = low[r] = tempo++;
+			proximo[r] = v_arr[r]->vizinhos;
+			pilha[topo++] = r;
+			pilha_2e[topo_2e++] = r;
+
+			while ( topo > 0 ) {
+				unsigned int v = pilha[topo - 1];
+				vizinho *viz = proximo[v];
+
+				if ( viz ) {
+					proximo[v] = viz->prox;
+					unsigned int u = viz->destino->id;
+
+					if ( desc[u] == -1 ) {
+						// Aresta de arvore
+						pai[u] = (int)v;
+						pai_aresta[u] = viz->aresta;
+						if ( v == r ) filhos_raiz++;
+
+						pilha_arestas[topo_arestas++] = (aresta_pilha){viz->aresta, v, u};
+						desc[u] = low[u] = tempo++;
+						proximo[u] = viz->destino->vizinhos;
+						pilha[topo++] = u;
+						pilha_2e[topo_2e++] = u;
+					} else if ( desc[u] < desc[v] && (pai[v] == -1 || viz->aresta != pai_aresta[v]) ) {
+						// Aresta para um ancestral (vista so do lado do descendente, logo empilhada uma vez).
+						// Arestas paralelas a aresta de arvore entram no bloco, mas so contam
+						// como retorno no modo multigrafo
+						pilha_arestas[topo_arestas++] = (aresta_pilha){viz->aresta, v, u};
+						if ( (g->multigrafo || (int)u != pai[v]) && desc[u] < low[v] ) {
+							low[v] = desc[u];
+						}
+					}
+					continue;
+				}
+
+				topo--;
+				if ( pai[v] == -1 ) continue;
+
+				unsigned int p = (unsigned int)pai[v];
+				if ( low[v] < low[p] ) {
+					low[p] = low[v];
+				}
+
+				if ( low[v] >= desc[p] ) {
+					if ( pai[p] != -1 ) bc->corte[p] = true;
+
+					// Fecha o bloco: desempilha ate a aresta de arvore {p, v}
+					unsigned int b = bc->n_blocos++;
+					aresta_pilha item;
+					do {
+						item = pilha_arestas[--topo_arestas];
+						bc->bloco_aresta[item.aresta] = b;
+						if ( marca[item.a] != b + 1 ) {
+							marca[item.a] = b + 1;
+							bc->no_vertice[item.a] = b;
+							bc->bloco_vertices[n_vert_blocos++] = item.a;
+						}
+						if ( marca[item.b] != b + 1 ) {
+							marca[item.b] = b + 1;
+							bc->no_vertice[item.b] = b;
+							bc->bloco_vertices[n_vert_blocos++] = item.b;
+						}
+					} while ( item.aresta != pai_aresta[v] );
+					bc->bloco_inicio[bc->n_blocos] = n_vert_blocos;
+				}
+
+				if ( low[v] > desc[p] ) {
+					bc->ponte[pai_aresta[v]] = true;
+
+					// Fecha o componente 2-aresta-conexo abaixo da ponte
+					unsigned int x;
+					do {
+						x = pilha_2e[--topo_2e];
+						bc->comp2e[x] = bc->n_comp2e;
+					} while ( x != v );
+					bc->n_comp2e++;
+				}
+			}
 
-	// Calcula tamanho total da string
-	size_t total_len = 0;
-	for ( unsigned int i = 0; i < total; i++ ) {
-		total_len += strlen (nomes[i]) + 1;	 // +1 para espaco ou '\0'
+			if ( filhos_raiz > 1 ) bc->corte[r] = true;
+
+			// O que sobrou na pilha forma o componente 2-aresta-conexo da raiz
+			while ( topo_2e > 0 ) {
+				bc->comp2e[pilha_2e[--topo_2e]] = bc->n_comp2e;
+			}
+			bc->n_comp2e++;
+		}
+
+		// Vertices de corte ganham seu proprio no; os demais ficam com o no do seu bloco
+		for ( unsigned int i = 0; i < n; i++ ) {
+			if ( bc->corte[i] ) bc->no_vertice[i] = bc->n_blocos + bc->n_cortes++;
+		}
+
+		ok = montar_arvore_bloco_corte (bc);
 	}
 
-	// Monta string final
-	char *resultado = malloc (total_len);
-	if ( !resultado ) {
-		free (nomes);
+	libera_temporario (g, v_arr);
+	libera_temporario (g, desc);
+	libera_temporario (g, low);
+	libera_temporario (g, pai);
+	libera_temporario (g, pai_aresta);
+	libera_temporario (g, marca);
+	libera_temporario (g, pilha);
+	libera_temporario (g, pilha_2e);
+	libera_temporario (g, proximo);
+	libera_temporario (g, pilha_arestas);
+
+	if ( !ok ) {
+		destruir_biconexao (bc);
+		fprintf (stderr, "Erro de memória em calcula_biconexao()\n");
 		return NULL;
 	}
 
-	resultado[0] = '\0';
-	for ( unsigned int i = 0; i < total; i++ ) {
-		strcat (resultado, nomes[i]);
-		if ( i < total - 1 ) strcat (resultado, " ");
-	}
+	g->biconexao = bc;
+	return bc;
+}
 
-	free (nomes);
-	return resultado;
+biconexao *calcula_biconexao (grafo *g) {
+	pthread_mutex_lock (&g->trava);
+	biconexao *bc = calcula_biconexao_travado (g);
+	pthread_mutex_unlock (&g->trava);
+	return bc;
 }
 
-void destruir_vetor_vertices (vertice **v_arr) {
-	free (v_arr);
+bool eh_vertice_corte (grafo *g, vertice *v) {
+	if ( g->incremental ) return g->incremental->blocos_vertice[v->id] >= 2;
+
+	biconexao *bc = calcula_biconexao (g);
+	return bc && bc->corte[v->id];
 }
 
-void destruir_vetores_auxiliares (int *desc, int *low, int *pai, bool *articulacao) {
-	free (desc);
-	free (low);
-	free (pai);
-	free (articulacao);
+bool eh_aresta_corte (grafo *g, unsigned int aresta) {
+	if ( g->incremental ) return aresta < g->n_arestas && ponte_incremental (g->incremental, aresta);
+
+	biconexao *bc = calcula_biconexao (g);
+	return bc && aresta < g->n_arestas && bc->ponte[aresta];
 }
 
-void dfs_articulacoes (vertice *v, vertice **v_arr, int *desc, int *low, int *pai, bool *articulacao, unsigned int n, int *tempo) {
-	int idx_v = indice_vertice (v_arr, n, v);
-	v->visitado = 1;
+unsigned int bloco_aresta (grafo *g, unsigned int aresta) {
+	biconexao *bc = calcula_biconexao (g);
+	if ( !bc || aresta >= g->n_arestas ) return SEM_BLOCO;
+	return bc->bloco_aresta[aresta];
+}
 
-	desc[idx_v] = low[idx_v] = (*tempo)++;
-	int filhos = 0;
+unsigned int n_blocos (grafo *g) {
+	biconexao *bc = calcula_biconexao (g);
+	return bc ? bc->n_blocos : 0;
+}
 
-	// Percorre todos os vizinhos do vertice v
-	for ( vizinho *viz = v->vizinhos; viz != NULL; viz = viz->prox ) {
-		vertice *u = viz->destino;
-		int idx_u = indice_vertice (v_arr, n, u);
+unsigned int componente_2_arestas (grafo *g, vertice *v) {
+	biconexao *bc = calcula_biconexao (g);
+	return bc ? bc->comp2e[v->id] : 0;
+}
 
-		if ( !u->visitado ) {
-			pai[idx_u] = idx_v;
-			filhos++;
+unsigned int n_componentes_2_arestas (grafo *g) {
+	biconexao *bc = calcula_biconexao (g);
+	return bc ? bc->n_comp2e : 0;
+}
 
-			dfs_articulacoes (u, v_arr, desc, low, pai, articulacao, n, tempo);
+unsigned int no_arvore_bloco_corte (grafo *g, vertice *v) {
+	biconexao *bc = calcula_biconexao (g);
+	return bc ? bc->no_vertice[v->id] : SEM_BLOCO;
+}
 
-			// Atualiza low de v com o menor low dos filhos
-			if ( low[idx_u] < low[idx_v] ) {
-				low[idx_v] = low[idx_u];
-			}
+//------------------------------------------------------------------------------
+// grafo em disco: corridas ordenadas, intercalacao e CSR mapeado com mmap
 
-			// Se v nao é raiz e low[u] >= desc[v], v é articulacao
-			if ( pai[idx_v] != -1 && low[idx_u] >= desc[idx_v] ) {
-				articulacao[idx_v] = true;
-			}
+#define MEMORIA_EXTERNO ((size_t)64 << 20)  // orcamento padrao para as arestas em memoria
 
-		} else if ( idx_u != pai[idx_v] ) {
-			// Se u já foi visitado e nao é o pai de v, temos uma aresta de retorno
-			if ( desc[idx_u] < low[idx_v] ) {
-				low[idx_v] = desc[idx_u];
-			}
-		}
-	}
+// Meia-aresta de uma corrida, com a origem
+typedef struct {
+	unsigned int origem;
+	unsigned int destino;
+	int peso;
+	unsigned int aresta;
+} registro_externo;
 
-	// Caso especial: se v é raiz e tem mais de um filho, é articulacao
-	if ( pai[idx_v] == -1 && filhos > 1 ) {
-		articulacao[idx_v] = true;
-	}
+static int cmp_registro (const void *a, const void *b) {
+	const registro_externo *x = a, *y = b;
+	if ( x->origem != y->origem ) return x->origem < y->origem ? -1 : 1;
+	if ( x->destino != y->destino ) return x->destino < y->destino ? -1 : 1;
+	return (x->aresta > y->aresta) - (x->aresta < y->aresta);
 }
 
-char *vertices_corte (grafo *g) {
-	vertice **v_arr = malloc (sizeof (vertice *) * g->n_vertices);
+// Cria um arquivo temporario em dir, ja removido do diretorio (some ao ser fechado)
+static FILE *arquivo_temporario (const char *dir) {
+	if ( !dir ) dir = getenv ("TMPDIR");
+	if ( !dir ) dir = "/tmp";
+
+	size_t tam = strlen (dir) + sizeof ("/grafo-XXXXXX");
+	char *modelo = malloc (tam);
+	if ( !modelo ) return NULL;
+	snprintf (modelo, tam, "%s/grafo-XXXXXX", dir);
+
+	FILE *f = NULL;
+	int fd = mkstemp (modelo);
+	if ( fd >= 0 ) {
+		unlink (modelo);
+		f = fdopen (fd, "w+b");
+		if ( !f ) close (fd);
+	}
+	if ( !f ) fprintf (stderr, "Erro ao criar arquivo temporário em %s\n", dir);
 
-	if ( !montar_vetor_vertices (g, v_arr) ) return NULL;
+	free (modelo);
+	return f;
+}
 
-	int *desc, *low, *pai;
-	bool *articulacao;
+#define MAX_CORRIDAS_ABERTAS 64  // maximo de corridas intercaladas de uma vez
+#define BLOCO_CORRIDA 1024       // registros lidos de cada corrida por vez, se o orcamento permitir
 
-	if ( !inicializar_vetores (&desc, &low, &pai, &articulacao, g->n_vertices) ) {
-		destruir_vetor_vertices (v_arr);
-		return NULL;
-	}
+// Corrida ordenada: registros [inicio, inicio + n) do arquivo de corridas
+typedef struct {
+	uint64_t inicio;
+	size_t n;
+} corrida;
 
-	int tempo = 0;
-	for ( unsigned int i = 0; i < g->n_vertices; i++ ) {
-		if ( !v_arr[i]->visitado ) {
-			dfs_articulacoes (v_arr[i], v_arr, desc, low, pai, articulacao, g->n_vertices, &tempo);
-		}
-	}
+// Ordena o buffer e grava no fim do arquivo de corridas como uma corrida nova
+static bool grava_corrida (registro_externo *buf, size_t n, FILE *f, corrida **corridas, size_t *n_corridas) {
+	qsort (buf, n, sizeof (registro_externo), cmp_registro);
 
-	char *resultado = montar_string_vertices_corte (v_arr, articulacao, g->n_vertices);
+	corrida *novo = realloc (*corridas, sizeof (corrida) * (*n_corridas + 1));
+	if ( !novo ) return false;
+	*corridas = novo;
 
-	destruir_vetor_vertices (v_arr);
-	destruir_vetores_auxiliares (desc, low, pai, articulacao);
+	uint64_t inicio = *n_corridas ? novo[*n_corridas - 1].inicio + novo[*n_corridas - 1].n : 0;
+	novo[(*n_corridas)++] = (corrida){inicio, n};
 
-	return resultado;
+	if ( fwrite (buf, sizeof (registro_externo), n, f) != n ) {
+		fprintf (stderr, "Erro ao gravar corrida em disco\n");
+		return false;
+	}
+	return true;
 }
 
-bool inicializar_arestas (char ***arestas, unsigned int capacidade) {
-	if ( capacidade == 0 ) {
-		capacidade = 1;
-	}
+// Cabeca de uma corrida durante a intercalacao, com o bloco ja lido do disco
+typedef struct {
+	registro_externo r;
+	registro_externo *bloco;
+	size_t pos, n_bloco, tam_bloco;
+	uint64_t prox, resta;  // proximo registro da corrida no arquivo e quantos faltam ler
+} cabeca_corrida;
 
-	*arestas = malloc (sizeof (char *) * capacidade);
-	if ( !*arestas ) return false;
+static bool menor_cabeca (const cabeca_corrida *a, const cabeca_corrida *b) {
+	return cmp_registro (&a->r, &b->r) < 0;
+}
 
-	// Inicializa os ponteiros com NULL (opcional, mas seguro para liberar depois)
-	for ( unsigned int i = 0; i < capacidade; i++ ) {
-		(*arestas)[i] = NULL;
+static void desce_cabecas (cabeca_corrida *h, size_t i, size_t n) {
+	for ( ;; ) {
+		size_t f = 2 * i + 1;
+		if ( f >= n ) break;
+		if ( f + 1 < n && menor_cabeca (&h[f + 1], &h[f]) ) f++;
+		if ( !menor_cabeca (&h[f], &h[i]) ) break;
+		cabeca_corrida tmp = h[i];
+		h[i] = h[f];
+		h[f] = tmp;
+		i = f;
 	}
+}
 
+// Le o proximo registro, da memoria (corrida unica) ou das corridas em disco (intercalacao)
+typedef struct {
+	const registro_externo *buf;
+	size_t n_buf, pos;
+	cabeca_corrida *heap;
+	size_t n_heap;
+	int fd;     // arquivo de corridas
+	bool erro;
+} intercalador;
+
+// Passa a cabeca c para o proximo registro da corrida, relendo o bloco quando acaba
+static bool avanca_cabeca (intercalador *it, cabeca_corrida *c) {
+	if ( c->pos == c->n_bloco ) {
+		if ( c->resta == 0 ) return false;
+
+		size_t n = c->resta < c->tam_bloco ? (size_t)c->resta : c->tam_bloco;
+		size_t tam = sizeof (registro_externo) * n;
+		if ( pread (it->fd, c->bloco, tam, (off_t)(c->prox * sizeof (registro_externo))) != (ssize_t)tam ) {
+			fprintf (stderr, "Erro ao ler corrida do disco\n");
+			it->erro = true;
+			return false;
+		}
+		c->prox += n;
+		c->resta -= n;
+		c->pos = 0;
+		c->n_bloco = n;
+	}
+	c->r = c->bloco[c->pos++];
 	return true;
 }
 
-void destruir_arestas (char **arestas, unsigned int total) {
-	if ( !arestas ) return;
-
-	for ( unsigned int i = 0; i < total; i++ ) {
-		free (arestas[i]);
+// Prepara a intercalacao de n corridas de fd; os cap registros de buf sao divididos
+// entre elas como blocos de leitura
+static bool inicia_intercalacao (intercalador *it, int fd, const corrida *c, size_t n, registro_externo *buf, size_t cap) {
+	*it = (intercalador){0};
+	it->fd = fd;
+	it->heap = malloc (sizeof (cabeca_corrida) * n);
+	if ( !it->heap ) {
+		fprintf (stderr, "Erro de memória em inicia_intercalacao()\n");
+		return false;
 	}
 
-	free (arestas);
+	size_t tam_bloco = cap / n;
+	for ( size_t i = 0; i < n; i++ ) {
+		cabeca_corrida *h = &it->heap[it->n_heap];
+		*h = (cabeca_corrida){.bloco = buf + i * tam_bloco, .tam_bloco = tam_bloco, .prox = c[i].inicio, .resta = c[i].n};
+		if ( avanca_cabeca (it, h) ) it->n_heap++;
+		else if ( it->erro ) return false;
+	}
+	for ( size_t i = it->n_heap / 2; i-- > 0; ) {
+		desce_cabecas (it->heap, i, it->n_heap);
+	}
+	return true;
 }
 
-bool adicionar_aresta_corte (const char *nome1, const char *nome2, char ***arestas, unsigned int *total, unsigned int *capacidade) {
-	// Ordena os nomes alfabeticamente
-	const char *a = (strcmp (nome1, nome2) < 0) ? nome1 : nome2;
-	const char *b = (a == nome1) ? nome2 : nome1;
-
-	size_t len = strlen (a) + strlen (b) + 2;
-	char *aresta = malloc (len);
-	if ( !aresta ) return false;
+static bool proximo_registro (intercalador *it, registro_externo *r) {
+	if ( it->buf ) {
+		if ( it->pos >= it->n_buf ) return false;
+		*r = it->buf[it->pos++];
+		return true;
+	}
 
-	snprintf (aresta, len, "%s %s", a, b);
+	if ( it->n_heap == 0 ) return false;
+	*r = it->heap[0].r;
+	if ( !avanca_cabeca (it, &it->heap[0]) ) {
+		if ( it->erro ) return false;
+		it->heap[0] = it->heap[--it->n_heap];
+	}
+	desce_cabecas (it->heap, 0, it->n_heap);
+	return true;
+}
 
-	// Expande o vetor, se necessario
-	if ( *total >= *capacidade ) {
-		*capacidade *= 2;
-		char **novo = realloc (*arestas, sizeof (char *) * (*capacidade));
-		if ( !novo ) {
-			free (aresta);
-			return false;
+// Uma passada da intercalacao: cada grupo de ate aridade corridas de *arq vira uma
+// corrida de um arquivo novo, que substitui *arq
+static bool intercala_passada (FILE **arq, corrida **corridas, size_t *n_corridas, size_t aridade, registro_externo *buf, size_t cap, const char *dir) {
+	size_t n_novas = (*n_corridas + aridade - 1) / aridade;
+	corrida *novas = malloc (sizeof (corrida) * n_novas);
+	FILE *saida = novas ? arquivo_temporario (dir) : NULL;
+	bool ok = saida != NULL;
+
+	uint64_t pos = 0;
+	for ( size_t i = 0; ok && i < n_novas; i++ ) {
+		size_t ini = i * aridade;
+		size_t n = (*n_corridas - ini < aridade) ? *n_corridas - ini : aridade;
+
+		intercalador it;
+		ok = inicia_intercalacao (&it, fileno (*arq), *corridas + ini, n, buf, cap);
+		novas[i].inicio = pos;
+		registro_externo r;
+		while ( ok && proximo_registro (&it, &r) ) {
+			ok = fwrite (&r, sizeof (registro_externo), 1, saida) == 1;
+			pos++;
 		}
-		*arestas = novo;
+		ok = ok && !it.erro;
+		novas[i].n = (size_t)(pos - novas[i].inicio);
+		free (it.heap);
+	}
+	if ( saida && (!ok || fflush (saida) != 0) ) {
+		fprintf (stderr, "Erro ao gravar corrida em disco\n");
+		ok = false;
 	}
 
-	(*arestas)[*total] = aresta;
-	(*total)++;
+	if ( !ok ) {
+		if ( saida ) fclose (saida);
+		free (novas);
+		return false;
+	}
+	fclose (*arq);
+	*arq = saida;
+	free (*corridas);
+	*corridas = novas;
+	*n_corridas = n_novas;
 	return true;
 }
 
-char *montar_string_arestas_corte (char **arestas, unsigned int total) {
-	if ( total == 0 ) return strdup ("");
+// Grava o CSR em f: inicio[0 .. n] (uint64_t) seguido das meias-arestas
+static bool grava_csr (grafo_externo *ge, intercalador *it, FILE *f) {
+	size_t cab = sizeof (uint64_t) * ((size_t)ge->n_vertices + 1);
+	uint64_t *inicio = calloc ((size_t)ge->n_vertices + 1, sizeof (uint64_t));
+	if ( !inicio ) return false;
+
+	bool ok = fseeko (f, (off_t)cab, SEEK_SET) == 0;
+	registro_externo r;
+	while ( ok && proximo_registro (it, &r) ) {
+		meia_aresta m = {r.destino, r.peso, r.aresta};
+		inicio[r.origem + 1]++;
+		ok = fwrite (&m, sizeof (meia_aresta), 1, f) == 1;
+	}
+	ok = ok && !it->erro;
+	for ( unsigned int v = 0; v < ge->n_vertices; v++ ) {
+		inicio[v + 1] += inicio[v];
+	}
 
-	qsort (arestas, total, sizeof (char *), cmpstr);
+	ok = ok && fseeko (f, 0, SEEK_SET) == 0 && fwrite (inicio, sizeof (uint64_t), (size_t)ge->n_vertices + 1, f) == (size_t)ge->n_vertices + 1;
+	ok = ok && fflush (f) == 0;
+	if ( !ok ) fprintf (stderr, "Erro ao gravar o CSR em disco\n");
 
-	// Calcula o tamanho total da string final
-	size_t total_len = 0;
-	for ( unsigned int i = 0; i < total; i++ ) {
-		total_len += strlen (arestas[i]) + 1;  // +1 para espaco ou \0
+	free (inicio);
+	return ok;
+}
+
+// Rotula os componentes com union-find sobre os ids, numa passada sequencial pelo CSR
+static bool componentes_externo (grafo_externo *ge) {
+	unsigned int n = ge->n_vertices;
+	unsigned int *pai = malloc (sizeof (unsigned int) * ((size_t)n + 1));
+	ge->componente = malloc (sizeof (unsigned int) * ((size_t)n + 1));
+	ge->membros = malloc (sizeof (unsigned int) * ((size_t)n + 1));
+	ge->inicio_componente = calloc ((size_t)n + 2, sizeof (unsigned int));
+	if ( !pai || !ge->componente || !ge->membros || !ge->inicio_componente ) {
+		free (pai);
+		return false;
 	}
 
-	// Aloca e monta a string final
-	char *resultado = malloc (total_len);
-	if ( !resultado ) return NULL;
+	for ( unsigned int v = 0; v < n; v++ ) {
+		pai[v] = v;
+	}
+	for ( unsigned int v = 0; v < n; v++ ) {
+		for ( uint64_t k = ge->inicio[v]; k < ge->inicio[v + 1]; k++ ) {
+			unsigned int a = uf_raiz (pai, v);
+			unsigned int b = uf_raiz (pai, ge->adj[k].destino);
+			if ( a < b ) pai[b] = a;
+			else if ( b < a ) pai[a] = b;
+		}
+	}
 
-	resultado[0] = '\0';
-	for ( unsigned int i = 0; i < total; i++ ) {
-		strcat (resultado, arestas[i]);
-		if ( i < total - 1 ) strcat (resultado, " ");
+	// Rotulos na ordem do menor id de cada componente, como calcula_componentes
+	unsigned int nc = 0;
+	for ( unsigned int v = 0; v < n; v++ ) {
+		unsigned int r = uf_raiz (pai, v);
+		ge->componente[v] = (r == v) ? nc++ : ge->componente[r];
+		ge->inicio_componente[ge->componente[v] + 1]++;
+	}
+	ge->n_componentes = nc;
+	for ( unsigned int c = 0; c < nc; c++ ) {
+		ge->inicio_componente[c + 1] += ge->inicio_componente[c];
 	}
 
-	return resultado;
+	// Vertices agrupados por componente, em ordem de id (pai serve de cursor)
+	memcpy (pai, ge->inicio_componente, sizeof (unsigned int) * nc);
+	for ( unsigned int v = 0; v < n; v++ ) {
+		ge->membros[pai[ge->componente[v]]++] = v;
+	}
+
+	free (pai);
+	return true;
 }
 
-void dfs_arestas_corte (vertice *v, vertice **v_arr, int *desc, int *low, int *pai, unsigned int n, int *tempo, char **arestas, unsigned int *total, unsigned int *capacidade) {
-	int idx_v = indice_vertice (v_arr, n, v);
-	v->visitado = 1;
-	desc[idx_v] = low[idx_v] = (*tempo)++;
+grafo_externo *le_grafo_externo (FILE *f, const char *dir, size_t memoria) {
+	if ( memoria == 0 ) memoria = MEMORIA_EXTERNO;
+	size_t cap = memoria / sizeof (registro_externo);
+	if ( cap < 2 ) cap = 2;
 
-	for ( vizinho *viz = v->vizinhos; viz != NULL; viz = viz->prox ) {
-		vertice *u = viz->destino;
-		int idx_u = indice_vertice (v_arr, n, u);
+	char linha[MAX_LINHA];
+	leitor l;
+	grafo_externo *ge = calloc (1, sizeof (grafo_externo));
+	registro_externo *buf = malloc (sizeof (registro_externo) * cap);
+	if ( !abre_leitor (&l, f) || !ge || !buf || !(ge->nomes = cria_grafo (NULL)) ) {
+		fecha_leitor (&l);
+		free (buf);
+		free (ge);
+		fprintf (stderr, "Erro de memória em le_grafo_externo()\n");
+		return NULL;
+	}
+	ge->mapa = MAP_FAILED;
+
+	// Le as arestas: os nomes viram ids densos em memoria (O(V)); as meias-arestas vao
+	// para o buffer, que e ordenado e gravado como uma corrida sempre que enche (todas
+	// as corridas ficam num arquivo so)
+	FILE *arq = NULL;
+	corrida *corridas = NULL;
+	size_t n_corridas = 0, n_buf = 0;
+	bool ok = true;
+	while ( ok && proxima_linha (&l, linha, MAX_LINHA) ) {
+		if ( linha[0] == '/' && linha[1] == '/' ) continue;
+		if ( strlen (linha) == 0 ) continue;
 
-		if ( !u->visitado ) {
-			pai[idx_u] = idx_v;
-			dfs_arestas_corte (u, v_arr, desc, low, pai, n, tempo, arestas, total, capacidade);
+		if ( !ge->nomes->nome ) {
+			ge->nomes->nome = strdup (linha);
+			ok = ge->nomes->nome != NULL;
+			continue;
+		}
 
-			if ( low[idx_u] < low[idx_v] ) {
-				low[idx_v] = low[idx_u];
-			}
+		char v1[1024], v2[1024];
+		int peso = 0;
 
-			if ( low[idx_u] > desc[idx_v] ) {
-				adicionar_aresta_corte (v->nome, u->nome, &arestas, total, capacidade);
-			}
+		if ( sscanf (linha, "%s -- %s %d", v1, v2, &peso) >= 2 ) {
+			unsigned int a = busca_ou_cria_vertice (ge->nomes, v1)->id;
+			unsigned int b = busca_ou_cria_vertice (ge->nomes, v2)->id;
 
-		} else if ( idx_u != pai[idx_v] ) {
-			if ( desc[idx_u] < low[idx_v] ) {
-				low[idx_v] = desc[idx_u];
+			if ( n_buf + 2 > cap ) {
+				if ( !arq ) arq = arquivo_temporario (dir);
+				ok = arq && grava_corrida (buf, n_buf, arq, &corridas, &n_corridas);
+				n_buf = 0;
 			}
+			buf[n_buf++] = (registro_externo){a, b, peso, ge->n_arestas};
+			buf[n_buf++] = (registro_externo){b, a, peso, ge->n_arestas};
+			ge->n_arestas++;
+		} else {
+			// vértice isolado
+			busca_ou_cria_vertice (ge->nomes, linha);
 		}
 	}
-}
+	fecha_leitor (&l);
+	ok = ok && !l.erro;
+	ge->n_vertices = ge->nomes->n_vertices;
+
+	// Intercala as corridas (ou ordena o buffer, se tudo coube nele) no CSR. O buffer
+	// vira os blocos de leitura das corridas; se ha mais corridas do que cabem numa
+	// intercalacao, grupos delas viram corridas mais longas em passadas sucessivas
+	intercalador it = {0};
+	if ( ok && n_corridas == 0 ) {
+		qsort (buf, n_buf, sizeof (registro_externo), cmp_registro);
+		it.buf = buf;
+		it.n_buf = n_buf;
+	} else if ( ok ) {
+		ok = (n_buf == 0 || grava_corrida (buf, n_buf, arq, &corridas, &n_corridas));
+		if ( ok && fflush (arq) != 0 ) {
+			fprintf (stderr, "Erro ao gravar corrida em disco\n");
+			ok = false;
+		}
 
-char *arestas_corte (grafo *g) {
-	vertice **v_arr = malloc (sizeof (vertice *) * g->n_vertices);
-	if ( !v_arr ) return NULL;
+		size_t aridade = cap / BLOCO_CORRIDA;
+		if ( aridade > MAX_CORRIDAS_ABERTAS ) aridade = MAX_CORRIDAS_ABERTAS;
+		if ( aridade < 2 ) aridade = 2;
+		while ( ok && n_corridas > aridade ) {
+			ok = intercala_passada (&arq, &corridas, &n_corridas, aridade, buf, cap, dir);
+		}
+		ok = ok && inicia_intercalacao (&it, fileno (arq), corridas, n_corridas, buf, cap);
+	}
 
-	if ( !montar_vetor_vertices (g, v_arr) ) {
-		destruir_vetor_vertices (v_arr);
-		return NULL;
+	FILE *csr = ok ? arquivo_temporario (dir) : NULL;
+	ok = csr && grava_csr (ge, &it, csr);
+
+	if ( arq ) fclose (arq);
+	free (corridas);
+	free (it.heap);
+	free (buf);
+
+	// Mapeia o CSR; o arquivo pode ser fechado (e some) enquanto o mapa existir
+	if ( ok ) {
+		ge->tam_mapa = sizeof (uint64_t) * ((size_t)ge->n_vertices + 1) + sizeof (meia_aresta) * 2 * (size_t)ge->n_arestas;
+		ge->mapa = mmap (NULL, ge->tam_mapa, PROT_READ, MAP_SHARED, fileno (csr), 0);
+		ok = ge->mapa != MAP_FAILED;
+		if ( !ok ) fprintf (stderr, "Erro ao mapear o CSR em memória\n");
 	}
+	if ( csr ) fclose (csr);
 
-	int *desc, *low, *pai;
-	bool *articulacao;
-	if ( !inicializar_vetores (&desc, &low, &pai, &articulacao, g->n_vertices) ) {
-		destruir_vetor_vertices (v_arr);
+	if ( ok ) {
+		ge->inicio = ge->mapa;
+		ge->adj = (const meia_aresta *)(ge->inicio + ge->n_vertices + 1);
+		ge->v_arr = malloc (sizeof (vertice *) * ((size_t)ge->n_vertices + 1));
+		ok = ge->v_arr && montar_vetor_vertices (ge->nomes, ge->v_arr) && componentes_externo (ge);
+	}
+
+	if ( !ok ) {
+		fecha_grafo_externo (ge);
 		return NULL;
 	}
+	return ge;
+}
 
-	// Inicializa vetor de arestas de corte
-	unsigned int total = 0;
-	unsigned int capacidade = g->n_arestas > 0 ? g->n_arestas : 1;
-	char **arestas = NULL;
-	if ( !inicializar_arestas (&arestas, capacidade) ) {
-		destruir_vetor_vertices (v_arr);
-		destruir_vetores_auxiliares (desc, low, pai, NULL);
+void fecha_grafo_externo (grafo_externo *ge) {
+	if ( !ge ) return;
+
+	if ( ge->mapa != MAP_FAILED ) munmap (ge->mapa, ge->tam_mapa);
+	destroi_grafo (ge->nomes);
+	free (ge->v_arr);
+	free (ge->componente);
+	free (ge->membros);
+	free (ge->inicio_componente);
+	free (ge);
+}
+
+grafo *carrega_componente (grafo_externo *ge, unsigned int c) {
+	if ( c >= ge->n_componentes ) return NULL;
+
+	grafo *g = cria_grafo (NULL);
+	if ( !g ) return NULL;
+	g->nome = strdup (ge->nomes->nome ? ge->nomes->nome : "");
+	if ( !g->nome ) {
+		destroi_grafo (g);
 		return NULL;
 	}
 
-	int tempo = 0;
-	for ( unsigned int i = 0; i < g->n_vertices; i++ ) {
-		if ( !v_arr[i]->visitado ) {
-			dfs_arestas_corte (v_arr[i], v_arr, desc, low, pai, g->n_vertices, &tempo, arestas, &total, &capacidade);
-		}
+	// Vertices em ordem de id global: o id local e a posicao em membros
+	const unsigned int *membros = &ge->membros[ge->inicio_componente[c]];
+	unsigned int tam = ge->inicio_componente[c + 1] - ge->inicio_componente[c];
+	vertice **local = malloc (sizeof (vertice *) * ((size_t)tam + 1));
+	if ( !local ) {
+		destroi_grafo (g);
+		return NULL;
+	}
+	for ( unsigned int i = 0; i < tam; i++ ) {
+		local[i] = busca_ou_cria_vertice (g, ge->v_arr[membros[i]]->nome);
 	}
 
-	char *resultado = montar_string_arestas_corte (arestas, total);
+	// Cada aresta entra uma vez, pela ponta de menor id; um laco aparece duas vezes
+	// seguidas na lista do vertice, com o mesmo id de aresta
+	for ( unsigned int i = 0; i < tam; i++ ) {
+		unsigned int v = membros[i];
+		unsigned int ultimo_laco = SEM_ARESTA;
+		for ( uint64_t k = ge->inicio[v]; k < ge->inicio[v + 1]; k++ ) {
+			const meia_aresta *m = &ge->adj[k];
+			if ( m->destino < v ) continue;
+			if ( m->destino == v ) {
+				if ( m->aresta == ultimo_laco ) continue;
+				ultimo_laco = m->aresta;
+			}
 
-	destruir_arestas (arestas, total);
-	destruir_vetor_vertices (v_arr);
-	destruir_vetores_auxiliares (desc, low, pai, articulacao);
+			// posicao do destino em membros (crescente)
+			unsigned int ini = 0, fim = tam;
+			while ( ini < fim ) {
+				unsigned int meio = ini + (fim - ini) / 2;
+				if ( membros[meio] < m->destino ) ini = meio + 1;
+				else fim = meio;
+			}
 
-	return resultado;
+			adiciona_vizinho_grafo (g, local[i], local[ini], m->peso, g->n_arestas);
+			adiciona_vizinho_grafo (g, local[ini], local[i], m->peso, g->n_arestas);
+			g->n_arestas++;
+		}
+	}
+
+	free (local);
+	monta_matriz_bits (g);
+	return g;
 }
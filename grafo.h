@@ -1,7 +1,10 @@
 #ifndef GRAFO_H
 #define GRAFO_H
 
+#include <limits.h>
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,32 +12,183 @@
 //------------------------------------------------------------------------------
 // estrutura de dados para representar um grafo
 
-#define MAX_COMPONENTES 1024
 #define MAX_LINHA 2048
+#define SEM_BLOCO UINT_MAX   // aresta sem bloco (laco) ou vertice sem no na arvore bloco-corte
+#define SEM_ARESTA UINT_MAX  // resultado de busca_aresta quando os vertices nao sao vizinhos
 
 typedef struct vertice {
 	char *nome;
 	struct vizinho *vizinhos;
 	struct vertice *prox;
-	int visitado;  // para BFS/DFS
+	unsigned int id;  // indice denso do vertice, de 0 a n_vertices - 1
 } vertice;
 
 typedef struct vizinho {
 	vertice *destino;
 	int peso;
+	unsigned int aresta;  // id da aresta, de 0 a n_arestas - 1, o mesmo nas duas pontas
 	struct vizinho *prox;
 } vizinho;
 
+// indice de biconectividade, calculado uma vez por calcula_biconexao e guardado no grafo
+//
+// os blocos sao as componentes biconexas com ao menos uma aresta; a arvore bloco-corte
+// tem n_blocos + n_cortes nos: os nos 0 .. n_blocos - 1 sao os blocos e o no n_blocos + k
+// e o k-esimo vertice de corte; cada vertice de corte e ligado aos blocos que o contem
+typedef struct biconexao {
+	bool *corte;                   // vertice de corte, indexado pelo id do vertice
+	bool *ponte;                   // aresta de corte, indexado pelo id da aresta
+	unsigned int *bloco_aresta;    // bloco de cada aresta (SEM_BLOCO para lacos)
+	unsigned int n_blocos;
+	unsigned int *bloco_inicio;    // vertices do bloco b: bloco_vertices[bloco_inicio[b] .. bloco_inicio[b + 1])
+	unsigned int *bloco_vertices;  // ids dos vertices de cada bloco
+	unsigned int n_cortes;
+	unsigned int *no_vertice;      // no do vertice na arvore bloco-corte: o seu proprio, se e de corte,
+	                               // senao o do unico bloco que o contem (SEM_BLOCO se isolado)
+	unsigned int *arvore_inicio;   // vizinhos do no x: arvore_adj[arvore_inicio[x] .. arvore_inicio[x + 1])
+	unsigned int *arvore_adj;
+	unsigned int n_comp2e;
+	unsigned int *comp2e;          // componente 2-aresta-conexo de cada vertice, indexado pelo id
+} biconexao;
+
+// politica para o peso de arestas paralelas removidas por compacta_arestas
+typedef enum {
+	PESO_MINIMO,         // fica o menor peso entre as copias
+	PESO_PRIMEIRO,       // fica o peso da primeira copia lida
+	PESO_MULTIPLICIDADE  // o peso passa a ser o numero de copias
+} politica_peso;
+
+// ordem dos ids dos vertices imposta por reordena_vertices
+typedef enum {
+	ORDEM_NENHUMA,  // nao reordena (vertices ficam espalhados na ordem de alocacao)
+	ORDEM_ENTRADA,  // ordem de primeira aparicao na entrada
+	ORDEM_BFS,      // ordem de visita de uma BFS por componente
+	ORDEM_RCM,      // Cuthill-McKee reverso: BFS a partir do vertice de menor grau, vizinhos por grau crescente, invertida
+	ORDEM_GRAU      // grau decrescente
+} ordem_vertices;
+
+// floresta bloco-corte mantida aresta a aresta (ver ativa_biconexao_incremental)
+typedef struct biconexao_incremental biconexao_incremental;
+
+// alocador por blocos (bump allocator) para os vertices, vizinhos e nomes de um grafo,
+// e deposito dos vetores temporarios das analises; limpa_arena devolve tudo de uma vez e
+// guarda os blocos e os vetores para o proximo grafo
+typedef struct arena arena;
+
+// opcoes de le_grafo_opcoes; zeradas equivalem a le_grafo
+typedef struct opcoes_leitura {
+	bool remover_paralelas;  // deixa uma so aresta entre cada par de vertices
+	politica_peso peso;      // peso da aresta que fica, se remover_paralelas
+	bool remover_lacos;      // descarta arestas xxx -- xxx
+	bool multigrafo;         // arestas paralelas contam como ciclos no calculo de pontes
+	ordem_vertices ordem;    // reordenacao aplicada depois da leitura
+	arena *arena;            // se nao NULL, vertices, vizinhos e nomes sao alocados nela
+	bool sem_matriz_bits;    // nao monta a matriz de bits nem em grafos densos
+} opcoes_leitura;
+
+// matriz de adjacencia em bits, montada pela leitura quando o grafo e denso
+// (ver usa_matriz_bits): a linha v tem ligado o bit w de cada vizinho w de v
+typedef struct matriz_bits {
+	unsigned int n;
+	size_t palavras;        // uint64_t por linha
+	uint64_t *bits;         // linha v em bits[v * palavras .. (v + 1) * palavras)
+} matriz_bits;
+
+// adjacencia compacta (CSR) usada pelas buscas de caminhos minimos: indices de 16 bits
+// quando os ids cabem, e sem vetor de pesos quando todas as arestas valem 1
+// (ver calcula_adjacencia_compacta)
+typedef struct adjacencia_compacta {
+	unsigned int n;
+	unsigned int largura;   // bytes por indice em destino: 2 (uint16_t) ou 4 (uint32_t)
+	bool ponderado;         // alguma aresta vale mais que 1
+	size_t *inicio;         // vizinhos de v em destino[inicio[v] .. inicio[v + 1])
+	void *destino;          // ids dos vizinhos, uint16_t ou uint32_t
+	int *peso;              // pesos ajustados (nao positivos valem 1), ou NULL se nao ponderado
+} adjacencia_compacta;
+
 struct grafo {
 	char *nome;
 	vertice *vertices;
 	unsigned int n_vertices;
 	unsigned int n_arestas;
 	unsigned int n_componentes;
+	unsigned int *componente;      // rotulo do componente de cada vertice, indexado por id
+	unsigned int *tam_componente;  // numero de vertices de cada componente
+	biconexao *biconexao;          // indice de biconectividade (NULL ate ser calculado)
+	bool multigrafo;               // pontes consideram arestas paralelas (ver modo_multigrafo)
+	unsigned int threads;          // threads de componentes e biconexao (ver modo_paralelo)
+	vertice *arena_vertices;       // vertices contiguos alocados por reordena_vertices (ou NULL)
+	size_t n_arena_vertices;
+	vizinho *arena_vizinhos;       // vizinhos contiguos alocados por reordena_vertices (ou NULL)
+	size_t n_arena_vizinhos;
+	pthread_mutex_t trava;         // protege o calculo sob demanda de componente e biconexao
+	vertice **tabela;              // tabela de dispersao dos vertices pelo nome (enderecamento aberto)
+	size_t cap_tabela;             // capacidade da tabela, potencia de 2
+	arena *arena;                  // arena dos vertices, vizinhos e nomes (ou NULL: malloc)
+	biconexao_incremental *incremental;  // cortes e pontes mantidos a cada insere_aresta (ou NULL)
+	adjacencia_compacta *compacta; // adjacencia das buscas (NULL ate ser calculada)
+	matriz_bits *densa;            // matriz de adjacencia em bits (NULL se o grafo nao e denso)
 };
 
 typedef struct grafo grafo;
 
+// estado de uma busca de caminhos minimos (ver excentricidade), de posse de quem chama
+//
+// as consultas nao escrevem nada nos vertices: todo estado de travessia vive em
+// contextos como este ou em vetores locais, entao um grafo ja lido pode ser consultado
+// por varias threads ao mesmo tempo, cada uma com o seu contexto
+typedef struct contexto_busca {
+	unsigned int n;
+	arena *arena;           // arena do grafo, de onde vieram os vetores (ou NULL: malloc)
+	vertice **v_arr;        // vertices indexados pelo id
+	int *dist;              // distancias da ultima busca, validas onde marca == geracao
+	unsigned int *marca;    // geracao em que cada vertice foi alcancado
+	unsigned int geracao;   // incrementada a cada busca, evita zerar os vetores
+	unsigned int *heap;     // heap binario de ids, pela distancia
+	unsigned int *pos;      // posicao de cada id no heap
+	const adjacencia_compacta *adj;  // adjacencia do grafo, percorrida pelas buscas
+	const matriz_bits *densa;        // matriz de bits do grafo, ou NULL
+	uint64_t *resto;                 // vertices nao alcancados, nas buscas pela matriz
+} contexto_busca;
+
+// limites garantidos para o diametro de um componente: inferior <= diametro <= superior
+typedef struct limites_diametro {
+	int inferior;
+	int superior;
+} limites_diametro;
+
+// centralidades de um vertice dentro do seu componente (ver calcula_centralidades)
+typedef struct centralidade {
+	int excentricidade;   // maior distancia ate outro vertice do componente
+	double proximidade;   // (tam - 1) / soma das distancias; 0 num componente de 1 vertice
+	double harmonica;     // soma de 1 / distancia sobre os outros vertices do componente
+	bool aproximada;      // estimada por amostragem (ver calcula_centralidades)
+} centralidade;
+
+// triangulos e coeficientes de agrupamento (ver calcula_agrupamento)
+typedef struct agrupamento {
+	unsigned long long triangulos;    // triangulos do grafo
+	unsigned long long *por_vertice;  // triangulos de cada vertice, indexado pelo id
+	double *local;                    // coeficiente local de cada vertice, indexado pelo id
+	double global;                    // transitividade: 3 * triangulos / caminhos de 2 arestas
+	double medio;                     // media dos coeficientes locais (0 nos de grau < 2)
+} agrupamento;
+
+// numeros de nucleo dos vertices (ver k_cores)
+typedef struct nucleos {
+	unsigned int *nucleo;      // maior k tal que o vertice esta no k-nucleo, indexado pelo id
+	unsigned int degeneracao;  // maior numero de nucleo do grafo
+} nucleos;
+
+// matriz de distancias entre todos os pares de vertices de um componente
+// (ver calcula_matriz_distancias)
+typedef struct matriz_distancias {
+	unsigned int n;         // vertices do componente
+	unsigned int passo;     // largura de uma linha (n arredondado para o tamanho do bloco)
+	unsigned int *ids;      // ids dos vertices em ordem crescente: a linha/coluna i e ids[i]
+	int *dist;              // dist[i * passo + j] = distancia entre ids[i] e ids[j]
+} matriz_distancias;
+
 //------------------------------------------------------------------------------
 // lê um grafo de f e o devolve
 //
@@ -129,30 +283,474 @@ char *vertices_corte (grafo *g);
 
 char *arestas_corte (grafo *g);
 
+//------------------------------------------------------------------------------
+// devolve uma "string" com as arestas de uma floresta geradora minima de g (uma arvore
+// geradora minima por componente), no formato de arestas_corte, e escreve em *peso
+// (se peso nao e NULL) a soma dos pesos dessas arestas
+//
+// arestas sem peso ou com peso nao positivo valem 1, como em diametros. Kruskal: as
+// arestas sao ordenadas por peso com ordenacao por digitos, dividida entre `threads`
+// threads (0 = uma por processador), e juntadas com union-find. Devolve NULL em caso
+// de erro de alocacao
+
+char *floresta_geradora_minima (grafo *g, long long *peso, unsigned int threads);
+
 //------------------------------------------------------------------------------
 // funcoes criadas
 
 /**
- * Calcula o numero de componentes conexas em um grafo nao direcionado.
+ * Le um grafo de f, como le_grafo, aplicando as opcoes dadas.
+ *
+ * @param f Arquivo de entrada, no formato descrito em le_grafo, em texto puro ou
+ *          comprimido com gzip ou zstd (detectados pelos bytes magicos do inicio).
+ * @param op Opcoes de leitura, ou NULL para o comportamento de le_grafo.
+ *
+ * @return O grafo lido, ou NULL se a entrada comprimida esta corrompida ou usa um
+ *         formato cujo suporte nao foi compilado (ver GRAFO_ZLIB e GRAFO_ZSTD no makefile).
+ *
+ * A entrada e lida (e descomprimida) em blocos grandes por uma thread separada, enquanto
+ * a thread que chamou interpreta as linhas e monta o grafo. Os vertices sao achados pelo
+ * nome numa tabela de dispersao, entao montar o grafo custa O(1) esperado por linha.
+ *
+ * Se op pede remocao de paralelas ou de lacos, chama compacta_arestas depois da leitura;
+ * depois, se op pede uma ordem, chama reordena_vertices.
+ */
+grafo *le_grafo_opcoes (FILE *f, const opcoes_leitura *op);
+
+/**
+ * Cria uma arena vazia.
+ *
+ * @return A arena, ou NULL em caso de erro de alocacao.
+ *
+ * Uma arena serve para ler muitos grafos em sequencia (por exemplo, uma por thread num
+ * processamento em lote) reaproveitando a mesma memoria: le_grafo_opcoes com op->arena
+ * aloca nela os vertices, vizinhos e nomes; destroi_grafo nao os libera um a um; e
+ * limpa_arena, chamada depois de destroi_grafo, deixa toda a memoria pronta para o
+ * proximo grafo. Uma arena so pode ser usada por um grafo de cada vez.
+ *
+ * As analises de um grafo lido na arena (contextos de busca, limites de diametros,
+ * biconexao, agrupamento, k-cores, floresta geradora e centralidades) tiram dela os seus
+ * vetores temporarios e os devolvem ao terminar; eles ficam guardados para o proximo
+ * grafo em vez de voltar ao malloc. Os resultados devolvidos e os indices guardados no
+ * grafo continuam alocados com malloc.
+ */
+arena *cria_arena (void);
+
+/**
+ * Descarta tudo o que foi alocado na arena, mantendo os blocos para reuso.
+ *
+ * @param a Arena (pode ser NULL).
+ */
+void limpa_arena (arena *a);
+
+/**
+ * Libera a arena, todos os seus blocos e os vetores temporarios guardados.
+ *
+ * @param a Arena (pode ser NULL).
+ */
+void destroi_arena (arena *a);
+
+/**
+ * Remove arestas paralelas e/ou lacos de g, renumerando os ids das arestas que ficam.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param op Opcoes; so remover_paralelas, peso e remover_lacos sao usados.
+ *
+ * @return Numero de arestas removidas.
+ *
+ * As arestas sao ordenadas pelo par de pontas (e pelo id, que segue a ordem de leitura),
+ * de modo que as copias de cada par ficam contiguas e sao resolvidas em uma passada.
+ * As listas de vizinhos sao compactadas no lugar, sem mudar a ordem das que ficam.
+ * Descarta o indice de biconectividade, que e recalculado sob demanda.
+ * Como as demais funcoes que alteram o grafo, nao pode rodar junto com consultas.
+ */
+unsigned int compacta_arestas (grafo *g, const opcoes_leitura *op);
+
+/**
+ * Renumera os vertices de g na ordem pedida e refaz o layout da estrutura em memoria.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param ordem Ordem desejada para os ids.
+ *
+ * @return true em caso de sucesso, false em caso de erro de alocacao (g fica inalterado).
+ *
+ * Os vertices passam a ocupar um vetor contiguo na ordem dos novos ids (e a lista
+ * g->vertices segue essa ordem), e as listas de vizinhos de todos os vertices passam
+ * a ocupar um unico vetor contiguo, na mesma ordem, cada lista ordenada pelo id do
+ * destino. Assim as travessias andam pela memoria quase sequencialmente.
+ * Nomes, ids de arestas e todos os resultados das consultas ficam iguais; os rotulos de
+ * componentes e o indice de biconectividade sao descartados e recalculados sob demanda.
+ */
+bool reordena_vertices (grafo *g, ordem_vertices ordem);
+
+/**
+ * Liga ou desliga o modo multigrafo no calculo de pontes.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param ativo Se true, a DFS de biconectividade ignora so a propria aresta de arvore
+ *              (pelo id) ao voltar para o pai, e arestas paralelas a ela formam ciclo,
+ *              deixando de ser pontes. Se false (padrao), toda aresta para o pai e ignorada,
+ *              como num grafo simples.
+ *
+ * Descarta o indice de biconectividade se o modo mudou.
+ */
+void modo_multigrafo (grafo *g, bool ativo);
+
+/**
+ * Escolhe quantas threads calcula_componentes e calcula_biconexao usam.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param threads 0 (padrao): uma por processador, e as versoes paralelas so rodam a
+ *                partir de 65536 vertices, onde compensam. 1: sempre as versoes seriais.
+ *                Mais de 1: sempre as versoes paralelas, com esse numero de threads,
+ *                qualquer que seja o tamanho do grafo (serve para conferi-las em grafos
+ *                pequenos).
+ *
+ * Os resultados sao os mesmos em qualquer modo; descarta os rotulos de componentes e o
+ * indice de biconectividade se o modo mudou.
+ */
+void modo_paralelo (grafo *g, unsigned int threads);
+
+/**
+ * Cria um contexto de busca para consultas de distancia em g.
+ *
+ * @param g Ponteiro para o grafo.
+ *
+ * @return O contexto, ou NULL em caso de erro de alocacao. Deve ser liberado com
+ *         destroi_contexto_busca. Cada thread deve usar o seu.
+ */
+contexto_busca *cria_contexto_busca (grafo *g);
+
+/**
+ * Libera um contexto criado por cria_contexto_busca.
+ *
+ * @param ctx Contexto (pode ser NULL).
+ */
+void destroi_contexto_busca (contexto_busca *ctx);
+
+/**
+ * Monta (uma vez) a adjacencia compacta de g, guardada no grafo.
+ *
+ * @param g Ponteiro para o grafo.
+ *
+ * @return A adjacencia, pertencente ao grafo (nao deve ser liberada), ou NULL em caso de
+ *         erro de alocacao. Pode ser chamada por varias threads ao mesmo tempo.
+ *
+ * O carregador escolhe a instancia mais estreita: indices de 16 bits ate 65536 vertices
+ * e, se todas as arestas valem 1, nenhum vetor de pesos. As buscas de excentricidade tem
+ * uma versao para cada largura (busca_compacta.inc), em largura quando nao ha pesos e
+ * Dijkstra quando ha, sem testar o peso de cada aresta.
+ */
+adjacencia_compacta *calcula_adjacencia_compacta (grafo *g);
+
+/**
+ * Calcula as distancias minimas a partir de origem (arestas sem peso ou com peso nao
+ * positivo valem 1; busca em largura se todas valem 1, senao Dijkstra com heap binario)
+ * e devolve a maior delas.
+ *
+ * @param origem Vertice de origem.
+ * @param ctx Contexto de busca do grafo de origem.
+ *
+ * @return A excentricidade de origem dentro do seu componente.
+ *
+ * Depois da chamada, distancia_busca devolve a distancia de origem a cada vertice.
+ */
+int excentricidade (vertice *origem, contexto_busca *ctx);
+
+/**
+ * Devolve a distancia ate v calculada pela ultima chamada de excentricidade com ctx.
+ *
+ * @param ctx Contexto de busca.
+ * @param v Vertice.
+ *
+ * @return A distancia, ou -1 se v nao foi alcancado.
+ */
+int distancia_busca (const contexto_busca *ctx, vertice *v);
+
+/**
+ * Calcula limites inferior e superior garantidos para o diametro de cada componente,
+ * gastando no maximo o orcamento dado.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param max_buscas Numero maximo de buscas de caminhos minimos (0 = sem limite).
+ * @param max_segundos Tempo maximo, em segundos (<= 0 = sem limite); conferido antes de
+ *                     cada busca, entao pode ser excedido pela duracao de uma busca.
+ *
+ * @return Vetor com n_componentes(g) limites, indexado pelo rotulo do componente, ou NULL
+ *         em caso de erro de alocacao. Deve ser liberado com free pelo chamador.
+ *
+ * Cada busca a partir de s da a excentricidade exata de s e, pela desigualdade triangular,
+ * os limites max(d(s, v), ecc(s) - d(s, v)) <= ecc(v) <= ecc(s) + d(s, v) para todo v do
+ * componente. O diametro fica entre a maior excentricidade inferior e a maior superior
+ * dos vertices que ainda podem superar o limite inferior. A primeira busca parte do vertice
+ * de maior grau e a segunda do mais distante dele (varredura dupla); depois as fontes
+ * alternam entre o vertice de maior limite superior e o de menor limite inferior.
+ * Os componentes sao refinados em rodizio ate os limites se encontrarem ou o orcamento
+ * acabar. Sem orcamento, devolve os diametros exatos (inferior == superior), e os
+ * componentes em que usa_matriz_distancias e verdadeiro saem direto da matriz de distancias.
+ */
+limites_diametro *limites_diametros (grafo *g, unsigned int max_buscas, double max_segundos);
+
+/**
+ * Calcula as distancias entre todos os pares de vertices do componente c com um
+ * Floyd-Warshall em blocos sobre uma matriz contigua (pesos como em excentricidade).
+ *
+ * @param g Ponteiro para o grafo.
+ * @param c Rotulo do componente (ver componente).
+ *
+ * @return A matriz, ou NULL se c nao for um componente de g ou em caso de erro de
+ *         alocacao. Deve ser liberada com destroi_matriz_distancias.
+ *
+ * Custa O(n^3) tempo e O(n^2) memoria para um componente de n vertices, mas cada passo
+ * e um min-plus sobre blocos que cabem no cache, vetorizado quando o compilador permite;
+ * para componentes pequenos e densos sai mais barato que n buscas de excentricidade.
+ * limites_diametros usa esta matriz sozinha nesses casos (ver usa_matriz_distancias).
+ */
+matriz_distancias *calcula_matriz_distancias (grafo *g, unsigned int c);
+
+/**
+ * Libera uma matriz de distancias.
+ *
+ * @param m Matriz (pode ser NULL).
+ */
+void destroi_matriz_distancias (matriz_distancias *m);
+
+/**
+ * Devolve a distancia entre u e v segundo a matriz m.
+ *
+ * @param m Matriz de distancias.
+ * @param u Vertice.
+ * @param v Vertice.
+ *
+ * @return A distancia, ou -1 se u ou v nao pertencem ao componente de m.
+ */
+int distancia_matriz (const matriz_distancias *m, vertice *u, vertice *v);
+
+/**
+ * Devolve a excentricidade de v segundo a matriz m.
+ *
+ * @param m Matriz de distancias.
+ * @param v Vertice.
+ *
+ * @return A excentricidade, ou -1 se v nao pertence ao componente de m.
+ */
+int excentricidade_matriz (const matriz_distancias *m, vertice *v);
+
+/**
+ * Calcula excentricidade, proximidade (closeness) e centralidade harmonica de todos os
+ * vertices, cada uma dentro do componente do vertice (pesos como em excentricidade).
+ *
+ * @param g Ponteiro para o grafo.
+ * @param threads Numero de threads (0 = uma por processador).
+ * @param amostras Componentes com mais vertices que isso sao estimados a partir de buscas
+ *                 de amostras fontes sorteadas (0 = tudo exato).
+ *
+ * @return Vetor com n_vertices(g) centralidades, indexado pelo id do vertice, ou NULL em
+ *         caso de erro de alocacao. Deve ser liberado com free pelo chamador.
+ *
+ * Sem amostragem, faz uma busca por vertice (as fontes sao divididas entre as threads, cada
+ * uma com seu contexto_busca), ou usa a matriz de distancias nos componentes em que
+ * usa_matriz_distancias e verdadeiro. Num componente amostrado, as fontes saem exatas e os
+ * demais vertices ficam com aproximada == true: proximidade e harmonica estimadas pela media
+ * das distancias ate as fontes, e excentricidade igual ao maior limite inferior
+ * max(d(s, v), ecc(s) - d(s, v)) sobre as fontes s. As fontes sao sorteadas com semente fixa.
+ */
+centralidade *calcula_centralidades (grafo *g, unsigned int threads, unsigned int amostras);
+
+/**
+ * Escreve em saida as centralidades de calcula_centralidades, uma linha por vertice em ordem
+ * de nome: "nome excentricidade proximidade harmonica", seguida de " ~" quando estimada.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param saida Arquivo de saida.
+ * @param threads Como em calcula_centralidades.
+ * @param amostras Como em calcula_centralidades.
+ *
+ * @return true se tudo foi escrito, false em caso de erro de alocacao ou de escrita.
+ */
+bool escreve_centralidades (grafo *g, FILE *saida, unsigned int threads, unsigned int amostras);
+
+/**
+ * Conta os triangulos de g e calcula os coeficientes de agrupamento local e global.
+ * Lacos sao ignorados e arestas paralelas contam uma vez.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param threads Numero de threads (0 = uma por processador).
+ *
+ * @return O resultado, a ser liberado com destroi_agrupamento, ou NULL em caso de erro de
+ *         alocacao.
+ *
+ * Os vertices sao numerados em ordem crescente de grau e cada aresta so e guardada na
+ * lista da ponta de menor numero, em vetores ordenados; cada triangulo e achado uma vez,
+ * pela intersecao das listas das suas duas pontas menores (intercalacao em blocos de 4
+ * com extensoes de vetor do gcc/clang, ou mapa de bits quando a lista de u e longa). Os
+ * vertices sao divididos entre as threads em lotes.
+ */
+agrupamento *calcula_agrupamento (grafo *g, unsigned int threads);
+
+/**
+ * Libera o resultado de calcula_agrupamento.
+ *
+ * @param a Ponteiro para o resultado (pode ser NULL).
+ */
+void destroi_agrupamento (agrupamento *a);
+
+/**
+ * Escreve em saida o resultado de calcula_agrupamento: uma linha
+ * "triangulos: T global: G medio: M" e depois uma linha por vertice em ordem de nome,
+ * "nome triangulos coeficiente_local".
+ *
+ * @param g Ponteiro para o grafo.
+ * @param saida Arquivo de saida.
+ * @param threads Como em calcula_agrupamento.
+ *
+ * @return true se tudo foi escrito, false em caso de erro de alocacao ou de escrita.
+ */
+bool escreve_agrupamento (grafo *g, FILE *saida, unsigned int threads);
+
+/**
+ * Decompoe g em k-nucleos: o k-nucleo e o maior subgrafo em que todo vertice tem grau
+ * pelo menos k. Lacos sao ignorados e arestas paralelas contam uma vez.
+ *
+ * @param g Ponteiro para o grafo.
+ *
+ * @return Os numeros de nucleo e a degeneracao, a ser liberados com destroi_nucleos, ou
+ *         NULL em caso de erro de alocacao.
+ *
+ * Algoritmo de Batagelj e Zaversnik: vertices em baldes por grau sobre os ids, sempre
+ * tirando o de menor grau, em O(n + m).
+ */
+nucleos *k_cores (grafo *g);
+
+/**
+ * Como k_cores, descascando por niveis em paralelo: no nivel k as threads tiram ao mesmo
+ * tempo os vertices de grau k, com os graus dos vizinhos decrementados atomicamente.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param threads Numero de threads (0 = uma por processador).
+ *
+ * @return Como em k_cores.
+ *
+ * Cada nivel varre os vertices uma vez, entao compensa em grafos grandes de degeneracao
+ * pequena; nos demais k_cores e mais rapido.
+ */
+nucleos *k_cores_paralelo (grafo *g, unsigned int threads);
+
+/**
+ * Libera o resultado de k_cores ou k_cores_paralelo.
+ *
+ * @param k Ponteiro para o resultado (pode ser NULL).
+ */
+void destroi_nucleos (nucleos *k);
+
+/**
+ * Diz se a matriz de adjacencia em bits compensa para um grafo, pelo tamanho e densidade.
+ *
+ * @param n Numero de vertices.
+ * @param arestas Numero de arestas.
+ *
+ * @return true se a matriz cabe em 32 MiB e ao menos 1/32 dos pares de vertices sao
+ *         arestas.
+ *
+ * Nesses grafos a leitura monta a matriz (guardada em g->densa, ao lado das listas, que
+ * continuam valendo para o resto da biblioteca). Componentes, bipartido e as buscas sem
+ * peso de excentricidade passam a andar por ela: os vizinhos ainda nao visitados de um
+ * vertice saem de uma vez, 64 por operacao, da linha dele com o conjunto dos nao
+ * visitados. compacta_arestas e reordena_vertices refazem a matriz; insere_aresta a
+ * atualiza, e a descarta se criar vertice.
+ */
+bool usa_matriz_bits (unsigned int n, size_t arestas);
+
+/**
+ * Grau de um vertice pela matriz de bits (vizinhos distintos, contando o proprio vertice
+ * se houver laco).
+ *
+ * @param m Ponteiro para a matriz.
+ * @param v Id do vertice.
+ *
+ * @return A contagem de bits da linha de v.
+ */
+unsigned int grau_matriz_bits (const matriz_bits *m, unsigned int v);
+
+/**
+ * Diz se a matriz de distancias compensa para um componente, pelo tamanho e densidade.
+ *
+ * @param n Numero de vertices do componente.
+ * @param arestas Numero de arestas do componente.
+ *
+ * @return true se o componente e pequeno o bastante para a matriz caber na memoria e
+ *         denso o bastante para o Floyd-Warshall ganhar das buscas de limites_diametros.
+ */
+bool usa_matriz_distancias (unsigned int n, size_t arestas);
+
+/**
+ * Calcula as componentes conexas de um grafo nao direcionado.
  *
  * @param g Ponteiro para o grafo cuja conectividade sera analisada.
  *
- * Atualiza o campo 'n_componentes' do grafo com o numero de componentes conexas.
+ * Usa union-find sobre os ids densos dos vertices: cada aresta liga (hooking) a raiz
+ * de maior id sob a de menor id, e os caminhos sao encurtados (pointer jumping) a cada
+ * busca. Nao usa recursao, entao funciona em grafos com componentes muito grandes.
+ *
+ * Atualiza os campos 'n_componentes', 'componente' e 'tam_componente' do grafo.
+ * Os componentes recebem rotulos de 0 a n_componentes - 1, na ordem do menor id
+ * de vertice que contem. Se ja estao calculados, nao faz nada; pode ser chamada por
+ * varias threads ao mesmo tempo.
  */
 void calcula_componentes (grafo *g);
 
+/**
+ * Devolve o rotulo do componente que contem o vertice v.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param v Vertice de g.
+ *
+ * @return Rotulo entre 0 e n_componentes(g) - 1.
+ *
+ * Calcula os componentes, se ainda nao calculados.
+ */
+unsigned int componente (grafo *g, vertice *v);
+
+/**
+ * Devolve o vetor de rotulos de componente de todos os vertices, indexado pelo id do vertice.
+ *
+ * @param g Ponteiro para o grafo.
+ *
+ * @return Vetor com n_vertices(g) rotulos, pertencente ao grafo (nao deve ser liberado),
+ *         ou NULL se o grafo nao tem vertices.
+ *
+ * Calcula os componentes, se ainda nao calculados.
+ */
+const unsigned int *rotulos_componentes (grafo *g);
+
+/**
+ * Devolve o numero de vertices do componente de rotulo c.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param c Rotulo do componente, entre 0 e n_componentes(g) - 1.
+ *
+ * @return Numero de vertices do componente, ou 0 se c nao e um rotulo valido.
+ *
+ * Calcula os componentes, se ainda nao calculados.
+ */
+unsigned int tamanho_componente (grafo *g, unsigned int c);
+
 /**
  * Executa a busca em profundidade (DFS) a partir de um vertice dado.
  *
  * @param v Ponteiro para o vertice inicial da busca.
+ * @param visitado Vetor de marcas indexado pelo id do vertice, de posse de quem chama.
  *
  * Marca todos os vertices alcancaveis a partir de 'v' como visitados.
  */
-void dfs (vertice *v);
+void dfs (vertice *v, bool *visitado);
 
 /**
  * Retorna o indice de um vertice em um vetor de ponteiros para vertices.
  *
+ * Se o vetor foi montado por montar_vetor_vertices, o indice e o id do vertice e a
+ * busca e O(1); caso contrario, e feita uma busca linear.
+ *
  * @param v_arr Vetor de ponteiros para vertices.
  * @param n Numero de elementos no vetor.
  * @param v Ponteiro para o vertice que se deseja encontrar.
@@ -190,14 +788,37 @@ int bfs_distancia_maxima(vertice *inicio, vertice **componente, int n_comp) ;
  * @param origem Ponteiro para o vertice de origem da aresta.
  * @param destino Ponteiro para o vertice de destino da aresta.
  * @param peso Peso associado a aresta.
+ * @param aresta Id da aresta, compartilhado pelas duas pontas.
  *
  * Cria uma nova estrutura de vizinho e a insere no inicio da lista de vizinhos do vertice de origem.
  */
-void adiciona_vizinho (vertice *origem, vertice *destino, int peso);
+void adiciona_vizinho (vertice *origem, vertice *destino, int peso, unsigned int aresta);
+
+/**
+ * Busca um vertice pelo nome no grafo, sem cria-lo, na tabela de dispersao de nomes.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param nome Nome do vertice.
+ *
+ * @return Ponteiro para o vertice, ou NULL se nao existe.
+ */
+vertice *busca_vertice (grafo *g, const char *nome);
+
+/**
+ * Busca uma aresta entre dois vertices.
+ *
+ * @param u Uma das pontas.
+ * @param v A outra ponta.
+ *
+ * @return Id de uma aresta {u, v}, ou SEM_ARESTA se u e v nao sao vizinhos.
+ */
+unsigned int busca_aresta (vertice *u, vertice *v);
 
 /**
  * Busca um vertice pelo nome no grafo. Caso nao exista, cria um novo vertice com esse nome.
  *
+ * A busca usa a tabela de dispersao de nomes do grafo, que cresce conforme necessario.
+ *
  * @param g Ponteiro para o grafo onde sera feita a busca ou insercao.
  * @param nome Nome do vertice a ser buscado ou criado.
  *
@@ -206,7 +827,9 @@ void adiciona_vizinho (vertice *origem, vertice *destino, int peso);
 vertice *busca_ou_cria_vertice (grafo *g, const char *nome);
 
 /**
- * Preenche um vetor com todos os vertices do grafo e zera o campo 'visitado' de cada um.
+ * Preenche um vetor com todos os vertices do grafo.
+ *
+ * Cada vertice e colocado na posicao do seu id.
  *
  * @param g Ponteiro para o grafo que contem os vertices.
  * @param v_arr Vetor a ser preenchido com os ponteiros para os vertices do grafo.
@@ -270,6 +893,28 @@ void destruir_vetor_vertices (vertice **v_arr);
  */
 void destruir_vetores_auxiliares (int *desc, int *low, int *pai, bool *articulacao);
 
+/**
+ * Executa, a partir de raiz, a DFS de biconectividade (Tarjan) que identifica vertices e
+ * arestas de corte, atualizando desc, low e pai.
+ *
+ * A DFS e iterativa, com pilha explicita, e os vertices sao indexados pelo id (ver
+ * montar_vetor_vertices), entao o custo e O(V + E) e nao ha risco de estourar a pilha
+ * de chamadas em componentes grandes.
+ *
+ * @param raiz Vertice onde a DFS comeca; deve ter desc == -1.
+ * @param v_arr Vetor com todos os vertices, indexado pelo id.
+ * @param desc Vetor de tempos de descoberta (-1 = nao visitado).
+ * @param low Vetor de menores tempos acessiveis.
+ * @param pai Vetor de pais na DFS.
+ * @param articulacao Vetor booleano de vertices de corte, ou NULL para nao calcula-los.
+ * @param n Numero total de vertices.
+ * @param tempo Ponteiro para o contador de tempo global.
+ * @param arestas Ponteiro para o vetor de strings das arestas de corte, ou NULL para nao calcula-las.
+ * @param total Ponteiro para a quantidade atual de arestas armazenadas.
+ * @param capacidade Ponteiro para a capacidade atual do vetor de arestas.
+ */
+void dfs_biconexao (vertice *raiz, vertice **v_arr, int *desc, int *low, int *pai, bool *articulacao, unsigned int n, int *tempo, char ***arestas, unsigned int *total, unsigned int *capacidade);
+
 /**
  * Executa uma DFS para identificar vertices de corte, atualizando desc, low, pai e articulacao.
  *
@@ -338,12 +983,160 @@ char *montar_string_arestas_corte (char **arestas, unsigned int total);
  * @param pai Vetor de pais dos vertices na DFS.
  * @param n Numero total de vertices.
  * @param tempo Ponteiro para o contador de tempo global.
- * @param arestas Vetor de strings onde as arestas de corte serao armazenadas.
+ * @param arestas Ponteiro para o vetor de strings onde as arestas de corte serao armazenadas
+ *                (pode ser realocado).
  * @param total Ponteiro para a quantidade atual de arestas armazenadas.
  * @param capacidade Ponteiro para a capacidade atual do vetor de arestas.
  */
-void dfs_arestas_corte (vertice *v, vertice **v_arr, int *desc, int *low, int *pai, unsigned int n, int *tempo, char **arestas, unsigned int *total, unsigned int *capacidade);
-int dijkstra_distancia_maxima(vertice *inicio, vertice **componente, int n_comp);
-int encontra_min_distancia(int *dist, bool *visitado, int n_comp);
+void dfs_arestas_corte (vertice *v, vertice **v_arr, int *desc, int *low, int *pai, unsigned int n, int *tempo, char ***arestas, unsigned int *total, unsigned int *capacidade);
+/**
+ * Calcula o indice de biconectividade de g (vertices e arestas de corte, blocos, arvore
+ * bloco-corte e componentes 2-aresta-conexos) e o guarda no grafo.
+ *
+ * @param g Ponteiro para o grafo.
+ *
+ * @return O indice, pertencente ao grafo (nao deve ser liberado), ou NULL em caso de erro
+ *         de alocacao. Chamadas seguintes devolvem o mesmo indice sem recalcular.
+ *         Pode ser chamada por varias threads ao mesmo tempo.
+ *
+ * Usa uma unica DFS iterativa de Tarjan com pilha de arestas (para fechar os blocos) e
+ * pilha de vertices (para fechar os componentes 2-aresta-conexos), em O(V + E). Em
+ * grafos grandes com mais de um processador usa o algoritmo de Tarjan-Vishkin: arvore
+ * geradora por busca em largura paralela, pre-ordem e limites das subarvores calculados
+ * nivel a nivel, e os blocos por union-find atomico sobre as arestas de arvore. Os
+ * rotulos dos blocos podem sair em outra ordem que os da DFS.
+ */
+biconexao *calcula_biconexao (grafo *g);
+
+/**
+ * Consultas O(1) sobre o indice de biconectividade, que e calculado se ainda nao existe.
+ *
+ * eh_vertice_corte e eh_aresta_corte dizem se o vertice/aresta e de corte;
+ * bloco_aresta devolve o bloco que contem a aresta (SEM_BLOCO para lacos);
+ * componente_2_arestas devolve o componente 2-aresta-conexo do vertice;
+ * no_arvore_bloco_corte devolve o no do vertice de corte na arvore bloco-corte,
+ * ou o no do unico bloco que contem o vertice, ou SEM_BLOCO se o vertice e isolado.
+ */
+bool eh_vertice_corte (grafo *g, vertice *v);
+bool eh_aresta_corte (grafo *g, unsigned int aresta);
+unsigned int bloco_aresta (grafo *g, unsigned int aresta);
+unsigned int n_blocos (grafo *g);
+unsigned int componente_2_arestas (grafo *g, vertice *v);
+unsigned int n_componentes_2_arestas (grafo *g);
+unsigned int no_arvore_bloco_corte (grafo *g, vertice *v);
+
+/**
+ * Libera o indice de biconectividade.
+ *
+ * @param bc Indice alocado por calcula_biconexao (pode ser NULL).
+ */
+void destruir_biconexao (biconexao *bc);
+
+// meia-aresta do CSR em disco de um grafo_externo
+typedef struct meia_aresta {
+	unsigned int destino;
+	int peso;
+	unsigned int aresta;
+} meia_aresta;
+
+// grafo em disco (ver le_grafo_externo): so os nomes e os rotulos ficam em memoria
+typedef struct grafo_externo {
+	grafo *nomes;                    // os vertices (nome e id denso), sem arestas
+	vertice **v_arr;                 // vertices de nomes indexados pelo id
+	unsigned int n_vertices;
+	unsigned int n_arestas;
+	const uint64_t *inicio;          // vizinhos de v em adj[inicio[v] .. inicio[v + 1]) (mmap)
+	const meia_aresta *adj;          // meias-arestas ordenadas por origem e destino (mmap)
+	void *mapa;                      // regiao mapeada com o CSR
+	size_t tam_mapa;
+	unsigned int n_componentes;
+	unsigned int *componente;        // rotulo do componente de cada vertice
+	unsigned int *membros;           // vertices agrupados por componente, em ordem de id
+	unsigned int *inicio_componente; // componente c em membros[inicio_componente[c] .. [c + 1])
+} grafo_externo;
+
+/**
+ * Le um grafo (mesmo formato de le_grafo, em texto puro ou comprimido) para o disco.
+ *
+ * @param f Arquivo de entrada.
+ * @param dir Diretorio dos arquivos temporarios (NULL = $TMPDIR ou /tmp).
+ * @param memoria Bytes de meias-arestas mantidos em memoria por vez (0 = 64 MiB).
+ *
+ * @return O grafo em disco, ou NULL em caso de erro de leitura, de disco ou de alocacao.
+ *         Deve ser liberado com fecha_grafo_externo.
+ *
+ * As meias-arestas, chaveadas pelo id denso da origem, enchem um buffer de memoria bytes
+ * que e ordenado e gravado como uma corrida num arquivo temporario; no fim as corridas sao
+ * intercaladas (heap de ate 64 vias, lendo cada corrida em blocos que dividem o mesmo
+ * buffer) num CSR em arquivo, acessado com mmap. Se ha mais corridas, grupos delas sao
+ * antes intercalados em corridas mais longas, em passadas sucessivas; assim so ficam
+ * abertos uns poucos arquivos. Os componentes sao calculados de
+ * forma semi-externa: union-find sobre os ids numa passada sequencial pelo CSR, com O(V)
+ * de memoria. Os arquivos temporarios sao removidos do diretorio assim que criados.
+ */
+grafo_externo *le_grafo_externo (FILE *f, const char *dir, size_t memoria);
+
+/**
+ * Libera um grafo em disco e o seu mapeamento.
+ *
+ * @param ge Grafo em disco (pode ser NULL).
+ */
+void fecha_grafo_externo (grafo_externo *ge);
+
+/**
+ * Carrega em memoria o componente c de um grafo em disco, como um grafo comum.
+ *
+ * @param ge Grafo em disco.
+ * @param c Rotulo do componente (0 .. ge->n_componentes - 1).
+ *
+ * @return O grafo do componente, com o nome do grafo original, ou NULL em caso de erro.
+ *         Deve ser liberado com destroi_grafo.
+ *
+ * Assim bipartido, vertices_corte, arestas_corte, diametros etc. rodam num componente
+ * por vez, com memoria proporcional ao maior componente.
+ */
+grafo *carrega_componente (grafo_externo *ge, unsigned int c);
+
+/**
+ * Ativa a manutencao incremental de vertices de corte e pontes: a partir daqui cada
+ * insere_aresta atualiza os cortes em tempo amortizado quase constante, e vertices_corte,
+ * arestas_corte, eh_vertice_corte e eh_aresta_corte passam a consulta-la.
+ *
+ * @param g Ponteiro para o grafo.
+ *
+ * @return true se ativada, false em caso de erro de alocacao.
+ *
+ * Mantem uma floresta bloco-corte com raiz em vertices: os blocos sao conjuntos de um
+ * union-find e uma aresta dentro de um componente une num bloco so todos os blocos do
+ * caminho entre as pontas (achado subindo das duas pontas ate o ancestral comum); uma
+ * aresta entre componentes vira um bloco novo, depois de re-enraizar a arvore menor.
+ * Um bloco de uma aresta so e uma ponte; um vertice em dois ou mais blocos e de corte.
+ * compacta_arestas, reordena_vertices e modo_multigrafo refazem a estrutura. Com ela
+ * ativa, n_componentes tambem segue atualizado. Custa O(V + E) memoria.
+ */
+bool ativa_biconexao_incremental (grafo *g);
+
+/**
+ * Desativa a manutencao incremental e libera a estrutura (nada acontece se nao ativa).
+ *
+ * @param g Ponteiro para o grafo.
+ */
+void desativa_biconexao_incremental (grafo *g);
+
+/**
+ * Insere a aresta {nome1, nome2} no grafo, criando os vertices que nao existirem.
+ *
+ * @param g Ponteiro para o grafo.
+ * @param nome1 Nome de uma ponta.
+ * @param nome2 Nome da outra ponta.
+ * @param peso Peso da aresta.
+ *
+ * @return O id da nova aresta.
+ *
+ * Descarta o indice de calcula_biconexao e os rotulos de componentes, que sao refeitos
+ * sob demanda; com ativa_biconexao_incremental, cortes e pontes sao atualizados na hora.
+ * Nao pode rodar junto com consultas ao grafo.
+ */
+unsigned int insere_aresta (grafo *g, const char *nome1, const char *nome2, int peso);
 
 #endif
@@ -1,32 +1,537 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <dirent.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "grafo.h"
 
 //------------------------------------------------------------------------------
-int main (void) {
-	grafo *g = le_grafo (stdin);
-	if ( !g ) {
-		fprintf (stderr, "Erro ao ler o grafo.\n");
-		return 1;
-	}
+// uso: ./teste < grafo.in
+//      ./teste [-j threads] [-o diretorio] [-c] [-a amostras] [-t] [-f] [-x temporarios [-m MiB]] arquivo|diretorio ...
+//
+// sem argumentos le um grafo da entrada padrao; com argumentos processa em lote
+// os arquivos dados (de um diretorio, os terminados em .in, .in.gz ou .in.zst),
+// maiores primeiro, num conjunto de threads. Com -o escreve diretorio/<nome>.out
+// para cada entrada; sem -o imprime os relatorios na ordem dos argumentos.
+// Com -c escreve tambem as centralidades de cada vertice (escreve_centralidades),
+// em diretorio/<nome>.centralidades ou logo depois do relatorio; -a estima as dos
+// componentes com mais de amostras vertices por amostragem. Com -t escreve os triangulos
+// e coeficientes de agrupamento (escreve_agrupamento), em diretorio/<nome>.agrupamento
+// ou logo depois do relatorio. Com -f escreve o peso e as arestas de uma floresta
+// geradora minima (floresta_geradora_minima), em diretorio/<nome>.floresta ou logo
+// depois do relatorio. Com -x le cada grafo para
+// o disco (le_grafo_externo, arquivos temporarios no diretorio dado, -m MiB de arestas
+// em memoria) e analisa um componente por vez; so o relatorio base, entao -x nao se
+// combina com -c, -a, -t nem -f.
+
+// Escreve em saida o relatorio de g no formato de sempre
+static void relatorio (grafo *g, FILE *saida) {
 	calcula_componentes (g);
 	char *s;
 
-	printf ("grafo: %s\n", nome (g));
-	printf ("%d vertices\n", n_vertices (g));
-	printf ("%d arestas\n", n_arestas (g));
-	printf ("%d componentes\n", n_componentes (g));
+	fprintf (saida, "grafo: %s\n", nome (g));
+	fprintf (saida, "%d vertices\n", n_vertices (g));
+	fprintf (saida, "%d arestas\n", n_arestas (g));
+	fprintf (saida, "%d componentes\n", n_componentes (g));
 
-	printf ("%sbipartido\n", bipartido (g) ? "" : "não ");
+	fprintf (saida, "%sbipartido\n", bipartido (g) ? "" : "não ");
 
-	printf ("diâmetros: %s\n", s = diametros (g));
+	fprintf (saida, "diâmetros: %s\n", s = diametros (g));
+	free (s);
 
-	printf ("vértices de corte: %s\n", s = vertices_corte (g));
+	fprintf (saida, "vértices de corte: %s\n", s = vertices_corte (g));
+	free (s);
 
-	printf ("arestas de corte: %s\n", s = arestas_corte (g));
+	fprintf (saida, "arestas de corte: %s\n", s = arestas_corte (g));
 	free (s);
-	// return 0;
+}
+
+static int cmp_nome (const void *a, const void *b) {
+	return strcmp (*(char * const *)a, *(char * const *)b);
+}
+
+static int cmp_int (const void *a, const void *b) {
+	int x = *(const int *)a, y = *(const int *)b;
+	return (x > y) - (x < y);
+}
+
+// Escreve os nomes ordenados, separados por espaco
+static void escreve_nomes (FILE *saida, char **nomes, size_t n) {
+	if ( n == 0 ) return;
+
+	qsort (nomes, n, sizeof (char *), cmp_nome);
+	for ( size_t i = 0; i < n; i++ ) {
+		fprintf (saida, i + 1 < n ? "%s " : "%s", nomes[i]);
+	}
+}
+
+// Acrescenta s ao vetor *v (com n elementos e capacidade *cap)
+static void acrescenta (char ***v, size_t *n, size_t *cap, char *s) {
+	if ( *n == *cap ) {
+		*cap = *cap ? 2 * *cap : 64;
+		char **novo = realloc (*v, sizeof (char *) * *cap);
+		if ( !novo ) {
+			fprintf (stderr, "Erro de memória em acrescenta()\n");
+			exit (1);
+		}
+		*v = novo;
+	}
+	(*v)[(*n)++] = s;
+}
+
+// Mesmo relatorio para um grafo em disco, juntando as analises de cada componente
+static bool relatorio_externo (grafo_externo *ge, FILE *saida) {
+	unsigned int nc = ge->n_componentes;
+	int *diams = malloc (sizeof (int) * ((size_t)nc + 1));
+	char **cortes = NULL, **pontes = NULL;
+	size_t n_cortes = 0, cap_cortes = 0, n_pontes = 0, cap_pontes = 0;
+	bool bip = true;
+	bool ok = diams != NULL;
+
+	for ( unsigned int c = 0; ok && c < nc; c++ ) {
+		grafo *g = carrega_componente (ge, c);
+		if ( !g ) {
+			ok = false;
+			break;
+		}
+		calcula_componentes (g);
+		bip = bip && bipartido (g);
+
+		char *s = diametros (g);
+		ok = s != NULL;
+		diams[c] = s ? atoi (s) : 0;
+		free (s);
+
+		for ( vertice *v = g->vertices; ok && v != NULL; v = v->prox ) {
+			if ( eh_vertice_corte (g, v) ) {
+				char *nome = strdup (v->nome);
+				ok = nome != NULL;
+				if ( nome ) acrescenta (&cortes, &n_cortes, &cap_cortes, nome);
+			}
+
+			for ( vizinho *viz = v->vizinhos; ok && viz != NULL; viz = viz->prox ) {
+				if ( v->id < viz->destino->id && eh_aresta_corte (g, viz->aresta) ) {
+					const char *a = v->nome, *b = viz->destino->nome;
+					if ( strcmp (a, b) > 0 ) {
+						a = viz->destino->nome;
+						b = v->nome;
+					}
+					size_t tam = strlen (a) + strlen (b) + 2;
+					char *par = malloc (tam);
+					ok = par != NULL;
+					if ( !par ) break;
+					snprintf (par, tam, "%s %s", a, b);
+					acrescenta (&pontes, &n_pontes, &cap_pontes, par);
+				}
+			}
+		}
+		destroi_grafo (g);
+	}
+
+	if ( ok ) {
+		fprintf (saida, "grafo: %s\n", ge->nomes->nome ? ge->nomes->nome : "");
+		fprintf (saida, "%d vertices\n", ge->n_vertices);
+		fprintf (saida, "%d arestas\n", ge->n_arestas);
+		fprintf (saida, "%d componentes\n", nc);
+
+		fprintf (saida, "%sbipartido\n", bip ? "" : "não ");
+
+		qsort (diams, nc, sizeof (int), cmp_int);
+		fprintf (saida, "diâmetros: ");
+		for ( unsigned int c = 0; c < nc; c++ ) {
+			fprintf (saida, c + 1 < nc ? "%d " : "%d", diams[c]);
+		}
+
+		fprintf (saida, "\nvértices de corte: ");
+		escreve_nomes (saida, cortes, n_cortes);
+		fprintf (saida, "\narestas de corte: ");
+		escreve_nomes (saida, pontes, n_pontes);
+		fprintf (saida, "\n");
+	}
+
+	for ( size_t i = 0; i < n_cortes; i++ ) {
+		free (cortes[i]);
+	}
+	for ( size_t i = 0; i < n_pontes; i++ ) {
+		free (pontes[i]);
+	}
+	free (cortes);
+	free (pontes);
+	free (diams);
+	return ok;
+}
+
+//------------------------------------------------------------------------------
+// processamento em lote
+
+typedef struct {
+	char *caminho;
+	off_t tamanho;
+	unsigned int ordem;  // posicao na linha de comando
+	char *texto;         // relatorio, quando impresso na saida padrao
+	size_t tam_texto;
+	bool ok;
+} tarefa;
+
+typedef struct {
+	tarefa *tarefas;
+	unsigned int n, cap;
+	unsigned int proxima;  // proxima tarefa a ser pega por uma thread
+	pthread_mutex_t trava;
+	const char *destino;   // diretorio de -o, ou NULL
+	bool centralidades;    // -c
+	unsigned int amostras; // -a
+	bool agrupamento;      // -t
+	bool floresta;         // -f
+	const char *externo;   // diretorio de -x, ou NULL
+	size_t memoria;        // -m, em bytes
+} lote;
+
+static const char *sufixos[] = {".in", ".in.gz", ".in.zst"};
+
+// Diz se nome termina em suf
+static bool termina_com (const char *nome, const char *suf) {
+	size_t n = strlen (nome), s = strlen (suf);
+	return n >= s && strcmp (nome + n - s, suf) == 0;
+}
+
+static void adiciona_tarefa (lote *l, const char *caminho, off_t tamanho) {
+	if ( l->n == l->cap ) {
+		l->cap = l->cap ? 2 * l->cap : 64;
+		tarefa *t = realloc (l->tarefas, sizeof (tarefa) * l->cap);
+		if ( !t ) {
+			fprintf (stderr, "Erro de memória em adiciona_tarefa()\n");
+			exit (1);
+		}
+		l->tarefas = t;
+	}
+
+	tarefa *t = &l->tarefas[l->n];
+	t->caminho = strdup (caminho);
+	if ( !t->caminho ) {
+		fprintf (stderr, "Erro de memória em adiciona_tarefa()\n");
+		exit (1);
+	}
+	t->tamanho = tamanho;
+	t->ordem = l->n++;
+	t->texto = NULL;
+	t->tam_texto = 0;
+	t->ok = false;
+}
+
+// Adiciona um arquivo ou, se for diretorio, as entradas de grafo dentro dele (em ordem de nome)
+static bool adiciona_caminho (lote *l, const char *caminho) {
+	struct stat st;
+	if ( stat (caminho, &st) != 0 ) {
+		fprintf (stderr, "Erro ao abrir %s\n", caminho);
+		return false;
+	}
+
+	if ( !S_ISDIR (st.st_mode) ) {
+		adiciona_tarefa (l, caminho, st.st_size);
+		return true;
+	}
+
+	DIR *d = opendir (caminho);
+	if ( !d ) {
+		fprintf (stderr, "Erro ao abrir %s\n", caminho);
+		return false;
+	}
+
+	char **nomes = NULL;
+	size_t n = 0, cap = 0;
+	struct dirent *e;
+	while ( (e = readdir (d)) != NULL ) {
+		bool entrada = false;
+		for ( size_t k = 0; k < sizeof (sufixos) / sizeof (sufixos[0]); k++ ) {
+			entrada = entrada || termina_com (e->d_name, sufixos[k]);
+		}
+		if ( !entrada ) continue;
+
+		if ( n == cap ) {
+			cap = cap ? 2 * cap : 64;
+			char **tmp = realloc (nomes, sizeof (char *) * cap);
+			if ( !tmp ) {
+				fprintf (stderr, "Erro de memória em adiciona_caminho()\n");
+				exit (1);
+			}
+			nomes = tmp;
+		}
+		size_t tam = strlen (caminho) + strlen (e->d_name) + 2;
+		nomes[n] = malloc (tam);
+		if ( !nomes[n] ) {
+			fprintf (stderr, "Erro de memória em adiciona_caminho()\n");
+			exit (1);
+		}
+		snprintf (nomes[n++], tam, "%s/%s", caminho, e->d_name);
+	}
+	closedir (d);
+
+	qsort (nomes, n, sizeof (char *), cmp_nome);
+	for ( size_t i = 0; i < n; i++ ) {
+		if ( stat (nomes[i], &st) == 0 && S_ISREG (st.st_mode) ) {
+			adiciona_tarefa (l, nomes[i], st.st_size);
+		}
+		free (nomes[i]);
+	}
+	free (nomes);
+	return true;
+}
+
+// Maiores primeiro, para que o ultimo arquivo grande nao fique sozinho no fim
+static int cmp_tamanho (const void *a, const void *b) {
+	const tarefa *x = a, *y = b;
+	if ( x->tamanho != y->tamanho ) return x->tamanho < y->tamanho ? 1 : -1;
+	return x->ordem < y->ordem ? -1 : (x->ordem > y->ordem);
+}
+
+static int cmp_ordem (const void *a, const void *b) {
+	const tarefa *x = a, *y = b;
+	return x->ordem < y->ordem ? -1 : (x->ordem > y->ordem);
+}
+
+// Caminho de saida de -o: destino/<nome do arquivo sem .in, .in.gz ou .in.zst><extensao>
+static char *caminho_saida (const char *destino, const char *entrada, const char *extensao) {
+	const char *base = strrchr (entrada, '/');
+	base = base ? base + 1 : entrada;
+
+	size_t n = strlen (base);
+	for ( size_t k = sizeof (sufixos) / sizeof (sufixos[0]); k > 0; k-- ) {
+		if ( termina_com (base, sufixos[k - 1]) ) {
+			n -= strlen (sufixos[k - 1]);
+			break;
+		}
+	}
+
+	size_t tam = strlen (destino) + n + strlen (extensao) + 2;
+	char *s = malloc (tam);
+	if ( s ) snprintf (s, tam, "%s/%.*s%s", destino, (int)n, base, extensao);
+	return s;
+}
+
+// Abre a saida de uma entrada: destino/<nome><extensao> com -o, ou o texto da tarefa
+static FILE *abre_saida (lote *l, tarefa *t, const char *extensao) {
+	if ( !l->destino ) return open_memstream (&t->texto, &t->tam_texto);
+
+	char *caminho = caminho_saida (l->destino, t->caminho, extensao);
+	FILE *saida = caminho ? fopen (caminho, "w") : NULL;
+	free (caminho);
+	return saida;
+}
+
+// Le uma entrada para o disco e a analisa um componente por vez
+static void processa_externo (lote *l, tarefa *t, FILE *f) {
+	grafo_externo *ge = le_grafo_externo (f, l->externo, l->memoria);
+	fclose (f);
+	if ( !ge ) {
+		fprintf (stderr, "Erro ao ler o grafo %s.\n", t->caminho);
+		return;
+	}
+
+	FILE *saida = abre_saida (l, t, ".out");
+	t->ok = saida && relatorio_externo (ge, saida);
+	t->ok = saida && fclose (saida) == 0 && t->ok;
+	if ( !t->ok ) fprintf (stderr, "Erro ao escrever o relatório de %s\n", t->caminho);
+
+	fecha_grafo_externo (ge);
+}
+
+// Escreve em saida o peso e as arestas de uma floresta geradora minima de g
+static bool escreve_floresta (grafo *g, FILE *saida) {
+	long long peso;
+	// as threads do lote ja ocupam os processadores
+	char *s = floresta_geradora_minima (g, &peso, 1);
+	if ( !s ) return false;
+
+	bool ok = fprintf (saida, "peso: %lld\narestas: %s\n", peso, s) >= 0;
+	free (s);
+	return ok;
+}
+
+// Le e analisa uma entrada usando a arena da thread
+static void processa (lote *l, tarefa *t, arena *a) {
+	FILE *f = fopen (t->caminho, "r");
+	if ( !f ) {
+		fprintf (stderr, "Erro ao abrir %s\n", t->caminho);
+		return;
+	}
+	if ( l->externo ) {
+		processa_externo (l, t, f);
+		return;
+	}
+
+	opcoes_leitura op = {0};
+	op.arena = a;
+	grafo *g = le_grafo_opcoes (f, &op);
+	fclose (f);
+	if ( !g ) {
+		fprintf (stderr, "Erro ao ler o grafo %s.\n", t->caminho);
+		limpa_arena (a);
+		return;
+	}
+
+	FILE *saida = abre_saida (l, t, ".out");
+	if ( saida ) {
+		relatorio (g, saida);
+		t->ok = true;
+
+		if ( l->centralidades && l->destino ) {
+			t->ok = fclose (saida) == 0;
+			saida = abre_saida (l, t, ".centralidades");
+			t->ok = t->ok && saida;
+		}
+
+		// as threads do lote ja ocupam os processadores: centralidades com uma so
+		if ( saida && l->centralidades ) t->ok = escreve_centralidades (g, saida, 1, l->amostras) && t->ok;
+
+		if ( saida && l->agrupamento && l->destino ) {
+			t->ok = fclose (saida) == 0 && t->ok;
+			saida = abre_saida (l, t, ".agrupamento");
+			t->ok = t->ok && saida;
+		}
+		if ( saida && l->agrupamento ) t->ok = escreve_agrupamento (g, saida, 1) && t->ok;
+
+		if ( saida && l->floresta && l->destino ) {
+			t->ok = fclose (saida) == 0 && t->ok;
+			saida = abre_saida (l, t, ".floresta");
+			t->ok = t->ok && saida;
+		}
+		if ( saida && l->floresta ) t->ok = escreve_floresta (g, saida) && t->ok;
+		if ( saida ) t->ok = fclose (saida) == 0 && t->ok;
+	}
+	if ( !t->ok ) fprintf (stderr, "Erro ao escrever o relatório de %s\n", t->caminho);
+
+	t->ok = destroi_grafo (g) && t->ok;
+	limpa_arena (a);
+}
+
+static void *trabalhador (void *arg) {
+	lote *l = arg;
+
+	arena *a = cria_arena ();
+	if ( !a ) {
+		fprintf (stderr, "Erro de memória em trabalhador()\n");
+		exit (1);
+	}
+
+	for ( ;; ) {
+		pthread_mutex_lock (&l->trava);
+		unsigned int i = l->proxima++;
+		pthread_mutex_unlock (&l->trava);
+		if ( i >= l->n ) break;
+
+		processa (l, &l->tarefas[i], a);
+	}
+
+	destroi_arena (a);
+	return NULL;
+}
+
+static void uso (const char *programa) {
+	fprintf (stderr, "uso: %s [-j threads] [-o diretorio] [-c] [-a amostras] [-t] [-f] [-x temporarios [-m MiB]] arquivo|diretorio ...\n", programa);
+}
+
+static int em_lote (int argc, char **argv) {
+	lote l = {0};
+	long threads = sysconf (_SC_NPROCESSORS_ONLN);
+	bool ok = true;
+
+	int opt;
+	while ( (opt = getopt (argc, argv, "j:o:ca:tfx:m:")) != -1 ) {
+		switch ( opt ) {
+			case 'j':
+				threads = strtol (optarg, NULL, 10);
+				break;
+			case 'o':
+				l.destino = optarg;
+				break;
+			case 'c':
+				l.centralidades = true;
+				break;
+			case 'a':
+				l.amostras = (unsigned int)strtoul (optarg, NULL, 10);
+				break;
+			case 't':
+				l.agrupamento = true;
+				break;
+			case 'f':
+				l.floresta = true;
+				break;
+			case 'x':
+				l.externo = optarg;
+				break;
+			case 'm':
+				l.memoria = (size_t)strtoul (optarg, NULL, 10) << 20;
+				break;
+			default:
+				uso (argv[0]);
+				return 1;
+		}
+	}
+
+	// o modo externo so tem o relatorio base, um componente por vez
+	if ( l.externo && (l.centralidades || l.amostras || l.agrupamento || l.floresta) ) {
+		fprintf (stderr, "-x não pode ser usado com -c, -a, -t ou -f\n");
+		uso (argv[0]);
+		return 1;
+	}
+
+	for ( int i = optind; i < argc; i++ ) {
+		ok = adiciona_caminho (&l, argv[i]) && ok;
+	}
+
+	if ( threads < 1 ) threads = 1;
+	if ( (unsigned long)threads > l.n ) threads = l.n ? (long)l.n : 1;
+
+	qsort (l.tarefas, l.n, sizeof (tarefa), cmp_tamanho);
+
+	pthread_mutex_init (&l.trava, NULL);
+	pthread_t *ids = malloc (sizeof (pthread_t) * (size_t)threads);
+	if ( !ids ) {
+		fprintf (stderr, "Erro de memória em em_lote()\n");
+		return 1;
+	}
+
+	// a thread principal tambem trabalha
+	long criadas = 0;
+	while ( criadas < threads - 1 && pthread_create (&ids[criadas], NULL, trabalhador, &l) == 0 ) {
+		criadas++;
+	}
+	trabalhador (&l);
+	for ( long i = 0; i < criadas; i++ ) {
+		pthread_join (ids[i], NULL);
+	}
+	free (ids);
+	pthread_mutex_destroy (&l.trava);
+
+	qsort (l.tarefas, l.n, sizeof (tarefa), cmp_ordem);
+	for ( unsigned int i = 0; i < l.n; i++ ) {
+		tarefa *t = &l.tarefas[i];
+		if ( t->texto ) fwrite (t->texto, 1, t->tam_texto, stdout);
+		ok = ok && t->ok;
+		free (t->texto);
+		free (t->caminho);
+	}
+	free (l.tarefas);
+
+	return !ok;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char **argv) {
+	if ( argc > 1 ) return em_lote (argc, argv);
+
+	grafo *g = le_grafo (stdin);
+	if ( !g ) {
+		fprintf (stderr, "Erro ao ler o grafo.\n");
+		return 1;
+	}
+	relatorio (g, stdout);
 
 	return !destroi_grafo (g);
 }
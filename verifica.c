@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grafo.h"
+
+//------------------------------------------------------------------------------
+// verificacoes de regressao da biblioteca
+//
+// uso: ./verifica
+//
+// cada verificacao monta um grafo pequeno e confere um resultado conhecido; imprime
+// as que falharam e termina com 1 se alguma falhou
+
+static unsigned int falhas = 0;
+
+static void confere (bool ok, const char *descricao) {
+	if ( ok ) return;
+
+	fprintf (stderr, "falhou: %s\n", descricao);
+	falhas++;
+}
+
+// le um grafo do texto dado
+static grafo *le_texto (const char *texto) {
+	FILE *f = tmpfile ();
+	if ( !f ) return NULL;
+
+	fputs (texto, f);
+	rewind (f);
+	grafo *g = le_grafo (f);
+	fclose (f);
+	return g;
+}
+
+// insere_aresta sem o modo incremental descarta os rotulos dos componentes; a contagem
+// tem que ser refeita, e nao ficar com o valor de antes da insercao
+static void componentes_depois_de_insere_aresta (bool incremental) {
+	grafo *g = le_texto ("g\na\nb\nc -- d\n");
+	if ( !g ) {
+		confere (false, "leitura do grafo");
+		return;
+	}
+	if ( incremental ) ativa_biconexao_incremental (g);
+
+	confere (n_componentes (g) == 3, "3 componentes antes de inserir a -- b");
+	insere_aresta (g, "a", "b", 1);
+	confere (n_componentes (g) == 2, "2 componentes depois de inserir a -- b");
+	insere_aresta (g, "b", "e", 1);
+	confere (n_componentes (g) == 2, "2 componentes depois de inserir b -- e (vertice novo)");
+	insere_aresta (g, "e", "c", 1);
+	confere (n_componentes (g) == 1, "1 componente depois de inserir e -- c");
+	destroi_grafo (g);
+}
+
+// texto de um grafo aleatorio com ate n vertices (v0 .. vn-1) e m arestas, com lacos,
+// arestas paralelas e vertices isolados; NULL em caso de erro de alocacao
+static char *grafo_aleatorio (unsigned int n, unsigned int m) {
+	size_t tam = 32 * ((size_t)n + m + 1);
+	char *texto = malloc (tam);
+	if ( !texto ) return NULL;
+
+	size_t pos = (size_t)snprintf (texto, tam, "g\n");
+	for ( unsigned int i = 0; i < m; i++ ) {
+		unsigned int a = (unsigned int)rand () % n;
+		unsigned int b = (unsigned int)rand () % n;
+		pos += (size_t)snprintf (texto + pos, tam - pos, "v%u -- v%u %d\n", a, b, 1 + rand () % 9);
+	}
+	for ( unsigned int v = 0; v < n; v++ ) {
+		if ( rand () % 4 == 0 ) pos += (size_t)snprintf (texto + pos, tam - pos, "v%u\n", v);
+	}
+	return texto;
+}
+
+// compara duas strings devolvidas pela biblioteca e as libera
+static bool mesmo_texto (char *a, char *b) {
+	bool igual = a && b && strcmp (a, b) == 0;
+	free (a);
+	free (b);
+	return igual;
+}
+
+// com modo_paralelo pedindo mais de uma thread, componentes e biconexao rodam nas
+// versoes paralelas mesmo em grafos pequenos; os rotulos, cortes e pontes tem que ser
+// os mesmos das versoes seriais
+static void paralelo_igual_ao_serial (void) {
+	for ( unsigned int k = 0; k < 400; k++ ) {
+		unsigned int n = (unsigned int)rand () % 41;
+		char *texto = grafo_aleatorio (n, n ? (unsigned int)rand () % (2 * n + 1) : 0);
+		grafo *s = texto ? le_texto (texto) : NULL;
+		grafo *p = texto ? le_texto (texto) : NULL;
+		free (texto);
+		if ( !s || !p ) {
+			confere (false, "leitura do grafo aleatorio");
+			destroi_grafo (s);
+			destroi_grafo (p);
+			return;
+		}
+
+		modo_multigrafo (s, k % 2);
+		modo_multigrafo (p, k % 2);
+		modo_paralelo (s, 1);
+		modo_paralelo (p, 2 + k % 7);
+
+		bool rotulos = n_componentes (s) == n_componentes (p);
+		for ( vertice *v = s->vertices; v; v = v->prox ) {
+			rotulos = rotulos && componente (s, v) == componente (p, busca_vertice (p, v->nome));
+		}
+		confere (rotulos, "rotulos dos componentes em paralelo iguais aos seriais");
+		confere (mesmo_texto (vertices_corte (s), vertices_corte (p)), "vertices de corte em paralelo iguais aos seriais");
+		confere (mesmo_texto (arestas_corte (s), arestas_corte (p)), "arestas de corte em paralelo iguais as seriais");
+		confere (n_blocos (s) == n_blocos (p) && n_componentes_2_arestas (s) == n_componentes_2_arestas (p),
+			"blocos e componentes 2-aresta-conexos em paralelo iguais aos seriais");
+
+		destroi_grafo (s);
+		destroi_grafo (p);
+	}
+}
+
+// sequencias aleatorias de insere_aresta, com lacos, arestas paralelas e vertices novos:
+// depois de cada insercao, os cortes e pontes (mantidos pela estrutura incremental, ou
+// recalculados sem ela) tem que ser os de um grafo lido do zero com as mesmas arestas
+static void insercoes_iguais_a_releitura (bool incremental) {
+	const unsigned int insercoes = 30;
+
+	for ( unsigned int k = 0; k < 60; k++ ) {
+		unsigned int n = 1 + (unsigned int)rand () % 12;
+		char *inicial = grafo_aleatorio (n, (unsigned int)rand () % (n + 1));
+		size_t tam = inicial ? strlen (inicial) + 32 * (size_t)insercoes + 1 : 0;
+		char *texto = inicial ? realloc (inicial, tam) : NULL;
+		grafo *g = texto ? le_texto (texto) : NULL;
+		if ( !g ) {
+			confere (false, "leitura do grafo aleatorio");
+			free (texto ? texto : inicial);
+			return;
+		}
+		modo_multigrafo (g, k % 2);
+		if ( incremental ) ativa_biconexao_incremental (g);
+
+		size_t pos = strlen (texto);
+		for ( unsigned int i = 0; i < insercoes; i++ ) {
+			// nomes ate v(n + i / 2): os que ainda nao existem sao criados
+			char a[16], b[16];
+			snprintf (a, sizeof (a), "v%u", (unsigned int)rand () % (n + 1 + i / 2));
+			snprintf (b, sizeof (b), "v%u", (unsigned int)rand () % 4 ? (unsigned int)rand () % (n + 1 + i / 2) : (unsigned int)rand () % n);
+			int peso = 1 + rand () % 9;
+			insere_aresta (g, a, b, peso);
+			pos += (size_t)snprintf (texto + pos, tam - pos, "%s -- %s %d\n", a, b, peso);
+
+			grafo *r = le_texto (texto);
+			if ( !r ) {
+				confere (false, "releitura do grafo");
+				break;
+			}
+			modo_multigrafo (r, k % 2);
+
+			// no modo simples as copias paralelas de uma ponte valem por uma aresta so, e
+			// qual copia fica marcada depende da busca; por id, so no modo multigrafo
+			bool pontes = n_arestas (g) == n_arestas (r);
+			for ( unsigned int e = 0; pontes && k % 2 && e < n_arestas (r); e++ ) {
+				pontes = eh_aresta_corte (g, e) == eh_aresta_corte (r, e);
+			}
+			confere (n_componentes (g) == n_componentes (r), "componentes depois de insere_aresta iguais aos da releitura");
+			confere (mesmo_texto (vertices_corte (g), vertices_corte (r)), "vertices de corte depois de insere_aresta iguais aos da releitura");
+			confere (mesmo_texto (arestas_corte (g), arestas_corte (r)), "arestas de corte depois de insere_aresta iguais as da releitura");
+			confere (pontes, "pontes por id depois de insere_aresta iguais as da releitura");
+			destroi_grafo (r);
+		}
+
+		destroi_grafo (g);
+		free (texto);
+	}
+}
+
+//------------------------------------------------------------------------------
+int main (void) {
+	componentes_depois_de_insere_aresta (false);
+	componentes_depois_de_insere_aresta (true);
+	srand (1);
+	paralelo_igual_ao_serial ();
+	insercoes_iguais_a_releitura (false);
+	insercoes_iguais_a_releitura (true);
+
+	if ( falhas ) {
+		fprintf (stderr, "%u verificacoes falharam\n", falhas);
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}